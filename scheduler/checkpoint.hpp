@@ -0,0 +1,418 @@
+// checkpoint.hpp
+// Snapshots of an in-flight run, so a long replay can stop and go on later,
+// or several what-if runs can go on from one shared prefix.
+//
+// A snapshot is taken between two steps of a scheduler's loop and has two
+// parts. The core decides the rest of the run: which processes are finished,
+// the remaining and first-dispatch times of those in flight, and the
+// scheduler's own loop state (clock, ready queues, the lottery generator).
+// The history is what the run has produced so far: the finished processes'
+// times, the Gantt chart, the metrics and, in a build with counters, the
+// counters, which come last and are flagged in the header. A light snapshot
+// leaves the finished times and the chart out; it is only restored against
+// the final tables of the run that took it.
+//
+// Integers are LEB128 varints, signed ones zigzagged, so times and indices
+// mostly take a byte or two. Snapshot files are
+//   "SIMSNAP\0", uint32 version, header, core and history
+// with the header naming the scheduler, the time type and the workload; a
+// snapshot only restores onto the same workload, where the processes it has
+// already run must be unchanged. Later processes may differ, which is how a
+// what-if continuation is forked.
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <queue>
+#include <random>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "metrics.hpp"
+
+namespace snapshot_detail {
+
+// The container behind a std::queue or std::priority_queue. Heaps are saved
+// as laid out, so ties pop in the same order after a restore.
+template <class Q> auto& containerOf(Q& q) {
+    struct Access : Q { static auto& get(Q& q) { return q.*(&Access::c); } };
+    return Access::get(q);
+}
+
+inline std::uint64_t mix(std::uint64_t h, std::uint64_t v) {
+    for (int i = 0; i < 8; ++i, v >>= 8) h = (h ^ (v & 0xff)) * 0x100000001b3ULL;
+    return h;
+}
+constexpr std::uint64_t kHashSeed = 0xcbf29ce484222325ULL;
+
+template <class T> struct IsQueue : std::false_type {};
+template <class T, class C> struct IsQueue<std::queue<T, C>> : std::true_type {};
+template <class T, class C, class Cmp> struct IsQueue<std::priority_queue<T, C, Cmp>> : std::true_type {};
+
+template <class T> struct IsSequence : std::false_type {};
+template <class T, class A> struct IsSequence<std::vector<T, A>> : std::true_type {};
+template <class T, class A> struct IsSequence<std::deque<T, A>> : std::true_type {};
+
+} // namespace snapshot_detail
+
+// Writes values; state reads and writes itself through the same
+// `ar(a, b, ...)` calls, so one function serves both directions.
+class SnapshotWriter {
+    std::string out;
+
+public:
+    std::string& bytes() { return out; }
+
+    void varint(std::uint64_t v) {
+        for (; v >= 0x80; v >>= 7) out += (char)(v | 0x80);
+        out += (char)v;
+    }
+    void svarint(long long v) { varint(((std::uint64_t)v << 1) ^ (std::uint64_t)(v >> 63)); }
+    void raw(const void* p, std::size_t n) { out.append((const char*)p, n); }
+    void blob(std::string_view s) { varint(s.size()); out.append(s.data(), s.size()); }
+
+    template <class... T> void operator()(T&... v) { (put(v), ...); }
+
+    template <class T> void put(T& v) {
+        using namespace snapshot_detail;
+        if constexpr (std::is_same_v<T, bool>) varint(v);
+        else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) svarint(v);
+        else if constexpr (std::is_integral_v<T>) varint(v);
+        else if constexpr (std::is_floating_point_v<T>) raw(&v, sizeof v);
+        else if constexpr (std::is_same_v<T, std::string>) blob(v);
+        else if constexpr (IsQueue<T>::value) put(containerOf(v));
+        else if constexpr (IsSequence<T>::value) { varint(v.size()); for (auto& e : v) put(e); }
+        else if constexpr (std::is_same_v<T, std::mt19937>) { std::ostringstream s; s << v; blob(s.str()); }
+        else std::apply([&](auto&... e) { (put(e), ...); }, as_tuple(v));
+    }
+
+private:
+    template <class A, class B> static auto as_tuple(std::pair<A, B>& p) { return std::tie(p.first, p.second); }
+    template <class... A> static std::tuple<A&...> as_tuple(std::tuple<A...>& t) {
+        return std::apply([](auto&... e) { return std::tie(e...); }, t);
+    }
+    // Anything else lists its fields: `auto fields() { return std::tie(...); }`
+    template <class T> static auto as_tuple(T& v) -> decltype(v.fields()) { return v.fields(); }
+};
+
+// Reads what a SnapshotWriter wrote. Running past the end or into a size
+// the rest cannot hold leaves the reader failed and values zeroed.
+class SnapshotReader {
+    const char* p;
+    const char* end;
+    bool good = true;
+
+public:
+    explicit SnapshotReader(std::string_view s) : p(s.data()), end(s.data() + s.size()) {}
+    bool ok() const { return good; }
+    bool done() const { return good && p == end; }
+    std::size_t left() const { return (std::size_t)(end - p); }
+    void fail() { good = false; p = end; }
+
+    std::uint64_t varint() {
+        std::uint64_t v = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (p == end) { fail(); return 0; }
+            unsigned char b = (unsigned char)*p++;
+            v |= (std::uint64_t)(b & 0x7f) << shift;
+            if (!(b & 0x80)) return v;
+        }
+        fail();
+        return 0;
+    }
+    long long svarint() { std::uint64_t v = varint(); return (long long)(v >> 1) ^ -(long long)(v & 1); }
+    void raw(void* out, std::size_t n) {
+        if ((std::size_t)(end - p) < n) { fail(); std::memset(out, 0, n); return; }
+        std::memcpy(out, p, n);
+        p += n;
+    }
+    std::string_view blob() {
+        std::uint64_t n = varint();
+        if ((std::uint64_t)(end - p) < n) { fail(); return {}; }
+        std::string_view s(p, n);
+        p += n;
+        return s;
+    }
+    // A count of items that take at least a byte each.
+    std::size_t count() {
+        std::uint64_t n = varint();
+        if (n > left()) { fail(); return 0; }
+        return (std::size_t)n;
+    }
+
+    template <class... T> void operator()(T&... v) { (get(v), ...); }
+
+    template <class T> void get(T& v) {
+        using namespace snapshot_detail;
+        if constexpr (std::is_same_v<T, bool>) v = varint() != 0;
+        else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) v = (T)svarint();
+        else if constexpr (std::is_integral_v<T>) v = (T)varint();
+        else if constexpr (std::is_floating_point_v<T>) raw(&v, sizeof v);
+        else if constexpr (std::is_same_v<T, std::string>) v = std::string(blob());
+        else if constexpr (IsQueue<T>::value) get(containerOf(v));
+        else if constexpr (IsSequence<T>::value) {
+            v.clear();
+            v.resize(count());
+            for (auto& e : v) get(e);
+        } else if constexpr (std::is_same_v<T, std::mt19937>) {
+            std::istringstream s{std::string(blob())};
+            if (!(s >> v)) fail();
+        } else std::apply([&](auto&... e) { (get(e), ...); }, as_tuple(v));
+    }
+
+private:
+    template <class A, class B> static auto as_tuple(std::pair<A, B>& p) { return std::tie(p.first, p.second); }
+    template <class... A> static std::tuple<A&...> as_tuple(std::tuple<A...>& t) {
+        return std::apply([](auto&... e) { return std::tie(e...); }, t);
+    }
+    template <class T> static auto as_tuple(T& v) -> decltype(v.fields()) { return v.fields(); }
+};
+
+// A snapshot taken or read back. `core` and `history` are encoded; two runs
+// whose cores match at the same time go on identically from there.
+struct Snapshot {
+    std::string scheduler;
+    long long quantum = 0;
+    int time_bits = 0;
+    bool counters = false;        // the history ends with the counters' state
+    bool full = true;
+    std::uint64_t processes = 0;
+    std::uint64_t ids = 0;        // hash of the process ids in table order
+    long long time = 0;
+    std::string core, history;
+};
+
+namespace snapshot_detail {
+
+template <class P> bool settled(const P& p) { return p.remaining_time == 0 && p.start_time >= 0; }
+template <class P> bool touched(const P& p) {
+    return p.remaining_time != p.burst_time || p.waiting_time != 0 || p.turnaround_time != 0 || p.start_time >= 0;
+}
+template <class P> std::uint64_t mixRow(std::uint64_t h, std::size_t i, const P& p) {
+    h = mix(h, i);
+    h = mix(h, (std::uint64_t)p.arrival_time);
+    h = mix(h, (std::uint64_t)p.burst_time);
+    h = mix(h, (std::uint64_t)p.priority);
+    return mix(h, (std::uint64_t)p.deadline);
+}
+
+} // namespace snapshot_detail
+
+template <class ProcTable> std::uint64_t hashIds(const ProcTable& procs) {
+    std::uint64_t h = snapshot_detail::kHashSeed;
+    for (const auto& p : procs) {
+        for (char c : p.id) h = (h ^ (unsigned char)c) * 0x100000001b3ULL;
+        h = snapshot_detail::mix(h, p.id.size());
+    }
+    return h;
+}
+
+// Process rows: the core lists finished processes as runs of the table and
+// the ones in flight with their times; the history holds a hash of every row
+// run so far, to check a restore against, and in full snapshots the times of
+// the finished ones.
+template <class ProcTable>
+void writeRows(SnapshotWriter& core, SnapshotWriter& history, const ProcTable& procs, bool full) {
+    using namespace snapshot_detail;
+    const std::size_t n = procs.size();
+    std::vector<std::size_t> runs;
+    for (std::size_t i = 0; i < n;) {
+        std::size_t from = i;
+        bool s = settled(procs[i]);
+        while (i < n && settled(procs[i]) == s) ++i;
+        if (runs.empty() && s) runs.push_back(0);
+        runs.push_back(i - from);
+    }
+    core.varint(runs.size());
+    for (std::size_t r : runs) core.varint(r);
+
+    std::uint64_t h = kHashSeed;
+    std::size_t live = 0;
+    for (const auto& p : procs) live += touched(p) && !settled(p);
+    core.varint(live);
+    SnapshotWriter done;
+    for (std::size_t i = 0, last = 0; i < n; ++i) {
+        const auto& p = procs[i];
+        if (!touched(p)) continue;
+        h = mixRow(h, i, p);
+        if (settled(p)) {
+            if (full) { done.svarint(p.waiting_time); done.svarint(p.turnaround_time); done.svarint(p.start_time); }
+            continue;
+        }
+        core.varint(i - last);
+        last = i + 1;
+        core.svarint(p.remaining_time);
+        core.svarint(p.waiting_time);
+        core.svarint(p.turnaround_time);
+        core.svarint(p.start_time);
+    }
+    history.raw(&h, sizeof h);
+    if (full) history.blob(done.bytes());
+}
+
+// Puts the rows back onto a freshly set-up table; `base` supplies the
+// finished processes' times for a light snapshot. False when the snapshot
+// does not fit the table.
+template <class ProcTable>
+bool readRows(SnapshotReader& core, SnapshotReader& history, ProcTable& procs, const ProcTable* base) {
+    using namespace snapshot_detail;
+    const std::size_t n = procs.size();
+    std::uint64_t h = kHashSeed, want = 0;
+    std::vector<char> done(n, 0);
+    std::size_t runs = core.count(), i = 0;
+    for (std::size_t r = 0; r < runs && core.ok(); ++r) {
+        std::uint64_t len = core.varint();
+        if (len > n - i) return false;
+        if (r % 2) std::fill(done.begin() + i, done.begin() + i + len, 1);
+        i += len;
+    }
+    if (i != n) return false;
+    std::size_t live = core.count();
+    std::vector<std::pair<std::size_t, std::size_t>> rows;   // (index, 0 settled / 1 live)
+    for (std::size_t k = 0, next = 0; k < live && core.ok(); ++k) {
+        std::uint64_t gap = core.varint();
+        if (gap >= n - next) return false;
+        auto& p = procs[next + gap];
+        p.remaining_time = core.svarint();
+        p.waiting_time = core.svarint();
+        p.turnaround_time = core.svarint();
+        p.start_time = core.svarint();
+        rows.emplace_back(next + gap, 1);
+        next += gap + 1;
+    }
+    history.raw(&want, sizeof want);
+    std::string_view finished = base ? std::string_view() : history.blob();
+    SnapshotReader times(finished);
+    for (std::size_t k = 0; k < n; ++k) {
+        if (!done[k]) continue;
+        auto& p = procs[k];
+        p.remaining_time = 0;
+        if (base) {
+            const auto& b = (*base)[k];
+            p.waiting_time = b.waiting_time; p.turnaround_time = b.turnaround_time; p.start_time = b.start_time;
+        } else {
+            p.waiting_time = times.svarint(); p.turnaround_time = times.svarint(); p.start_time = times.svarint();
+        }
+        rows.emplace_back(k, 0);
+    }
+    std::sort(rows.begin(), rows.end());
+    for (auto [k, live_row] : rows) h = mixRow(h, k, procs[k]);
+    return core.ok() && history.ok() && times.ok() && h == want;
+}
+
+// Gantt segments as process indices, IDLE as n and anything else by name.
+template <class ProcTable, class Chart>
+void writeGantt(SnapshotWriter& w, const ProcTable& procs, const Chart& gantt, bool full) {
+    w.varint(gantt.size());
+    if (!full) return;
+    const std::size_t n = procs.size();
+    std::unordered_map<std::string_view, std::size_t> index;
+    index.reserve(n);
+    for (std::size_t i = 0; i < n; ++i) index.emplace(procs[i].id, i);
+    for (const auto& e : gantt) {
+        auto it = e.first == "IDLE" ? index.end() : index.find(e.first);
+        if (e.first == "IDLE") w.varint(n);
+        else if (it != index.end()) w.varint(it->second);
+        else { w.varint(n + 1); w.blob(e.first); }
+        w.svarint(e.second);
+    }
+}
+
+template <class ProcTable, class Chart>
+bool readGantt(SnapshotReader& r, const ProcTable& procs, Chart& gantt, const Chart* base) {
+    const std::size_t n = procs.size();
+    std::uint64_t size = r.varint();
+    gantt.clear();
+    if (base) {
+        if (size > base->size()) return false;
+        gantt.assign(base->begin(), base->begin() + size);
+        return r.ok();
+    }
+    if (size > r.left()) return false;
+    gantt.reserve(size);
+    for (std::size_t k = 0; k < size && r.ok(); ++k) {
+        std::uint64_t id = r.varint();
+        std::string name = id < n ? procs[id].id : id == n ? std::string("IDLE") : std::string(r.blob());
+        gantt.emplace_back(std::move(name), r.svarint());
+    }
+    return r.ok();
+}
+
+// Gantt segments the run had produced when it took `s`.
+inline std::uint64_t snapshotSegments(const Snapshot& s) {
+    SnapshotReader r(s.history);
+    std::uint64_t rows = 0;
+    r.raw(&rows, sizeof rows);
+    if (s.full) r.blob();
+    return r.varint();
+}
+
+// `pattern` with "%t" replaced by the snapshot's time, so every snapshot
+// gets its own file; without it each one replaces the last.
+inline std::string snapshotPath(std::string pattern, long long time) {
+    std::size_t at = pattern.find("%t");
+    if (at != std::string::npos) pattern.replace(at, 2, std::to_string(time));
+    return pattern;
+}
+
+inline void writeSnapshotFile(std::ostream& out, const Snapshot& s) {
+    SnapshotWriter w;
+    w.raw("SIMSNAP\0", 8);
+    std::uint32_t version = 3;
+    w.raw(&version, sizeof version);
+    std::string scheduler = s.scheduler;
+    bool counters = s.counters, full = s.full;
+    long long quantum = s.quantum, time = s.time;
+    int bits = s.time_bits;
+    std::uint64_t processes = s.processes;
+    w(scheduler, quantum, bits, counters, full, processes);
+    w.raw(&s.ids, sizeof s.ids);
+    w.svarint(time);
+    w.blob(s.core);
+    w.blob(s.history);
+    out.write(w.bytes().data(), (std::streamsize)w.bytes().size());
+}
+
+// Writes `s` to `path`, through a temporary file so a crash mid-write
+// leaves the previous snapshot in place.
+inline bool saveSnapshot(const std::string& path, const Snapshot& s) {
+    std::string tmp = path + ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out) return false;
+        writeSnapshotFile(out, s);
+        if (!out.flush()) return false;
+    }
+    return std::rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+inline bool loadSnapshot(const std::string& path, Snapshot& s, std::string& error) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) { error = "Could not open snapshot: " + path; return false; }
+    std::string bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    SnapshotReader r(bytes);
+    char magic[8];
+    std::uint32_t version = 0;
+    r.raw(magic, 8);
+    r.raw(&version, sizeof version);
+    if (!r.ok() || std::memcmp(magic, "SIMSNAP\0", 8) != 0 || version != 3) {
+        error = "Not a snapshot: " + path;
+        return false;
+    }
+    r(s.scheduler, s.quantum, s.time_bits, s.counters, s.full, s.processes);
+    r.raw(&s.ids, sizeof s.ids);
+    s.time = r.svarint();
+    s.core = std::string(r.blob());
+    s.history = std::string(r.blob());
+    if (!r.done()) { error = "Truncated snapshot: " + path; return false; }
+    return true;
+}
@@ -0,0 +1,156 @@
+// counters.hpp
+// Per-run instrumentation counters. Schedulers take the counter type as a
+// template parameter: SchedCounters<false> keeps no counts, so an
+// uninstrumented scheduler only pays for the trace ring stores and the
+// metrics events every run needs.
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <tuple>
+
+#include "metrics.hpp"
+#include "progress.hpp"
+#include "timeline.hpp"
+#include "trace_ring.hpp"
+
+struct RunCounters {
+    std::uint64_t dispatches = 0;        // scheduling decisions (one per slice or tick run)
+    std::uint64_t context_switches = 0;  // dispatches of a different process than the last one
+    std::uint64_t enqueues = 0;          // ready-queue insertions, including re-queues
+    std::uint64_t dequeues = 0;          // ready-queue removals
+    std::uint64_t idle_jumps = 0;        // clock advances with nothing ready
+    std::uint64_t completions = 0;
+    std::size_t max_ready_depth = 0;
+    double schedule_seconds = 0;         // wall clock spent inside schedule()
+
+    std::uint64_t events() const { return dispatches + enqueues + dequeues + idle_jumps + completions; }
+    auto fields() {
+        return std::tie(dispatches, context_switches, enqueues, dequeues, idle_jumps, completions,
+                        max_ready_depth, schedule_seconds);
+    }
+};
+
+// Hooks shared by both counter flavours: every event goes to the trace ring,
+// with processes identified by their index in the vector being scheduled, and
+// first dispatches and completions feed the run's metrics and, when attached,
+// its windowed series and timeline export.
+class RunHooks {
+    const void* base = nullptr;
+    MetricsAccumulator* metrics = nullptr;
+protected:
+    TraceRing* ring = nullptr;          // this thread's, looked up once per run
+    WindowSeries* series = nullptr;
+    TimelineWriter* timeline = nullptr;
+    template <class P> std::uint32_t handle(const P* who) const {
+        return (std::uint32_t)(who - static_cast<const P*>(base));
+    }
+    template <class P> void start(P* procs, MetricsAccumulator* m) {
+        base = procs;
+        metrics = m;
+        ring = &traceRing();
+        ring->clear();
+    }
+    template <class P> void dispatched(P* who, long long now, std::size_t depth) {
+        ring->record(TraceEvent::Dispatch, now, handle(who), depth);
+        if (series) series->dispatch(now, depth);
+        if (timeline) timeline->dispatch(handle(who), *who, now);
+        if (who->start_time < 0) {
+            who->start_time = now;
+            metrics->firstDispatch(who->arrival_time, now);
+        }
+    }
+    template <class P> void completed(const P* who, long long now) {
+        ring->record(TraceEvent::Complete, now, handle(who), 0);
+        metrics->complete(who->waiting_time, who->turnaround_time, who->burst_time);
+        if (series) series->complete(now, who->waiting_time);
+        if (timeline) timeline->complete(handle(who), *who, now);
+    }
+};
+
+template <bool Enabled> class SchedCounters;
+
+template <> class SchedCounters<false> : RunHooks {
+public:
+    static constexpr bool enabled = false;
+    // Whether schedulers should emit events they only derive for reporting,
+    // such as arrivals into an implicit ready set.
+    static constexpr bool observed = SIM_TRACE_RING != 0;
+    template <class P> void reset(P* procs, MetricsAccumulator* m) { start(procs, m); }
+    void attach(Heartbeat*) {}
+    void attach(WindowSeries* s) { series = s; }
+    void attach(TimelineWriter* t) { timeline = t; }
+    template <class P> void dispatch(P* who, std::size_t depth, long long now) {
+        dispatched(who, now, depth);
+    }
+    template <class P> void enqueue(const P* who, std::size_t depth, long long now) {
+        ring->record(TraceEvent::Enqueue, now, handle(who), depth);
+    }
+    void dequeue() {}
+    void idle(long long now) { ring->record(TraceEvent::Idle, now, 0, 0); }
+    template <class P> void complete(const P* who, long long now) { completed(who, now); }
+    void elapsed(double) {}
+    const RunCounters* get() const { return nullptr; }
+    // Saves or restores the counts through a checkpoint archive.
+    template <class Archive, class P> void transfer(Archive&, const P*) {}
+};
+
+template <> class SchedCounters<true> : RunHooks {
+    RunCounters c;
+    const void* last = nullptr;
+    Heartbeat* heartbeat = nullptr;
+    std::uint32_t countdown = 0;
+public:
+    static constexpr bool enabled = true;
+    static constexpr bool observed = true;
+    template <class P> void reset(P* procs, MetricsAccumulator* m) {
+        start(procs, m);
+        c = RunCounters();
+        last = nullptr;
+        if (heartbeat) countdown = heartbeat->initialCountdown();
+    }
+    void attach(Heartbeat* h) { heartbeat = h; }
+    void attach(WindowSeries* s) { series = s; }
+    void attach(TimelineWriter* t) { timeline = t; }
+    // `who` is the dispatched process, `depth` the ready-queue length the
+    // decision was made over and `now` the simulated time.
+    template <class P> void dispatch(P* who, std::size_t depth, long long now) {
+        dispatched(who, now, depth);
+        ++c.dispatches;
+        if (who != last) { ++c.context_switches; last = who; }
+        c.max_ready_depth = std::max(c.max_ready_depth, depth);
+        if (heartbeat && --countdown == 0) countdown = heartbeat->check(now, c.completions, c.events(), depth);
+    }
+    template <class P> void enqueue(const P* who, std::size_t depth, long long now) {
+        ring->record(TraceEvent::Enqueue, now, handle(who), depth);
+        ++c.enqueues;
+        c.max_ready_depth = std::max(c.max_ready_depth, depth);
+    }
+    void dequeue() { ++c.dequeues; }
+    void idle(long long now) { ring->record(TraceEvent::Idle, now, 0, 0); ++c.idle_jumps; }
+    template <class P> void complete(const P* who, long long now) {
+        completed(who, now);
+        ++c.completions;
+    }
+    void elapsed(double seconds) { c.schedule_seconds += seconds; }
+    const RunCounters* get() const { return &c; }
+    template <class Archive, class P> void transfer(Archive& ar, const P* procs) {
+        long long prev = last ? static_cast<const P*>(last) - procs : -1;
+        ar(c, prev);
+        last = prev < 0 ? nullptr : procs + prev;
+    }
+};
+
+void printCountersJson(std::ostream& out, const std::string& scheduler, const RunCounters& c) {
+    out << "{\"scheduler\": \"" << scheduler << "\""
+        << ", \"dispatches\": " << c.dispatches
+        << ", \"context_switches\": " << c.context_switches
+        << ", \"enqueues\": " << c.enqueues
+        << ", \"dequeues\": " << c.dequeues
+        << ", \"idle_jumps\": " << c.idle_jumps
+        << ", \"completions\": " << c.completions
+        << ", \"max_ready_depth\": " << c.max_ready_depth
+        << ", \"schedule_seconds\": " << c.schedule_seconds << "}\n";
+}
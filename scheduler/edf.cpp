@@ -4,6 +4,7 @@
 #include <vector>
 #include <string>
 #include <algorithm>
+#include <tuple>
 
 struct Process {
     std::string id;
@@ -0,0 +1,155 @@
+// gantt_index.hpp
+// Query index over a finished schedule. Segment start times are a prefix sum
+// of the durations, so "who ran at t" is a binary search; a second prefix sum
+// of CPU time answers utilization over any range in O(log n), and per-process
+// segment lists (one shared array, sliced by offsets) answer "all segments
+// of P" without scanning the chart.
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <istream>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "results.hpp"
+
+class GanttIndex {
+public:
+    static constexpr std::size_t npos = (std::size_t)-1;
+
+    // `ids` names the id indices used by `seg_ids`; "IDLE" marks idle time.
+    GanttIndex(std::vector<std::string> ids, const std::vector<std::uint32_t>& seg_ids,
+               const std::vector<std::int64_t>& durations)
+        : names(std::move(ids)), seg(seg_ids) {
+        std::size_t n = seg.size();
+        starts.resize(n + 1);
+        busy.resize(n + 1);
+        starts[0] = busy[0] = 0;
+        for (std::uint32_t i = 0; i < names.size(); ++i) lookup.emplace(names[i], i);
+        auto idle = lookup.find("IDLE");
+        idle_id = idle == lookup.end() ? npos : idle->second;
+        for (std::size_t i = 0; i < n; ++i) {
+            starts[i + 1] = starts[i] + durations[i];
+            busy[i + 1] = busy[i] + (seg[i] == idle_id ? 0 : durations[i]);
+        }
+        // Counting sort of segment indices by process keeps each list in time order.
+        offsets.assign(names.size() + 1, 0);
+        for (std::uint32_t id : seg) ++offsets[id + 1];
+        for (std::size_t i = 1; i < offsets.size(); ++i) offsets[i] += offsets[i - 1];
+        by_proc.resize(n);
+        std::vector<std::size_t> fill(offsets.begin(), offsets.end() - 1);
+        for (std::size_t i = 0; i < n; ++i) by_proc[fill[seg[i]]++] = i;
+    }
+
+    std::size_t size() const { return seg.size(); }
+    std::int64_t end() const { return starts.back(); }
+    std::int64_t start(std::size_t i) const { return starts[i]; }
+    std::int64_t duration(std::size_t i) const { return starts[i + 1] - starts[i]; }
+    const std::string& id(std::size_t i) const { return names[seg[i]]; }
+
+    // Segment running at `t`, or npos outside the schedule.
+    std::size_t at(std::int64_t t) const {
+        if (t < 0 || t >= end()) return npos;
+        return (std::size_t)(std::upper_bound(starts.begin(), starts.end(), t) - starts.begin()) - 1;
+    }
+
+    // CPU time in [t1, t2).
+    std::int64_t busyTime(std::int64_t t1, std::int64_t t2) const {
+        return t2 > t1 ? busyBefore(t2) - busyBefore(t1) : 0;
+    }
+
+    // Segments overlapping [t1, t2), as a half-open index range.
+    std::pair<std::size_t, std::size_t> overlapping(std::int64_t t1, std::int64_t t2) const {
+        t1 = std::max<std::int64_t>(t1, 0);
+        t2 = std::min(t2, end());
+        if (t1 >= t2) return {0, 0};
+        std::size_t lo = at(t1);
+        std::size_t hi = (std::size_t)(std::lower_bound(starts.begin(), starts.end() - 1, t2) - starts.begin());
+        return {lo, hi};
+    }
+
+    // Indices of `name`'s segments in time order, limited to those
+    // overlapping [t1, t2); empty when the id is unknown.
+    std::pair<const std::size_t*, const std::size_t*> segmentsOf(const std::string& name,
+            std::int64_t t1 = INT64_MIN, std::int64_t t2 = INT64_MAX) const {
+        auto it = lookup.find(name);
+        if (it == lookup.end()) return {nullptr, nullptr};
+        const std::size_t* lo = by_proc.data() + offsets[it->second];
+        const std::size_t* hi = by_proc.data() + offsets[it->second + 1];
+        lo = std::partition_point(lo, hi, [&](std::size_t i) { return starts[i + 1] <= t1; });
+        hi = std::partition_point(lo, hi, [&](std::size_t i) { return starts[i] < t2; });
+        return {lo, hi};
+    }
+
+private:
+    std::vector<std::string> names;
+    std::unordered_map<std::string, std::uint32_t> lookup;
+    std::size_t idle_id;
+    std::vector<std::uint32_t> seg;       // id index per segment
+    std::vector<std::int64_t> starts;     // starts[i]: start of segment i; starts[n]: end
+    std::vector<std::int64_t> busy;       // CPU time before segment i
+    std::vector<std::size_t> offsets;     // by_proc slice of each id
+    std::vector<std::size_t> by_proc;
+
+    std::int64_t busyBefore(std::int64_t t) const {
+        if (t <= 0) return 0;
+        if (t >= end()) return busy.back();
+        std::size_t i = at(t);
+        return busy[i] + (seg[i] == idle_id ? 0 : t - starts[i]);
+    }
+};
+
+inline GanttIndex buildGanttIndex(const LoadedResults& r) {
+    std::vector<std::uint32_t> ids;
+    std::vector<std::int64_t> durations;
+    ids.reserve(r.segments.size());
+    durations.reserve(r.segments.size());
+    for (const auto& sg : r.segments) { ids.push_back(sg.id); durations.push_back(sg.duration); }
+    return GanttIndex(r.ids, ids, durations);
+}
+
+// Answers one query per input line:
+//   at T                 segment running at T
+//   util T1 T2           CPU utilization over [T1, T2)
+//   range T1 T2          segments overlapping [T1, T2)
+//   segments P [T1 T2]   segments of process P, optionally within [T1, T2)
+// Segments print as "id start duration", "none" when there are none, and
+// every answer ends with a blank line.
+inline void runGanttQueries(const GanttIndex& index, std::istream& in, std::ostream& out) {
+    OutBuffer b(out);
+    auto segment = [&](std::size_t i) {
+        b.put(index.id(i)).put(' ').num((long long)index.start(i)).put(' ').num((long long)index.duration(i)).put('\n');
+    };
+    std::string line, cmd;
+    while (std::getline(in, line)) {
+        std::istringstream q(line);
+        if (!(q >> cmd) || cmd[0] == '#') continue;
+        long long t1 = 0, t2 = 0;
+        if (cmd == "at" && q >> t1) {
+            std::size_t i = index.at(t1);
+            if (i == GanttIndex::npos) b.put("none\n");
+            else segment(i);
+        } else if (cmd == "util" && q >> t1 >> t2) {
+            b.num6(t2 > t1 ? 100.0 * index.busyTime(t1, t2) / (t2 - t1) : 0).put("%\n");
+        } else if (cmd == "range" && q >> t1 >> t2) {
+            auto [lo, hi] = index.overlapping(t1, t2);
+            for (std::size_t i = lo; i < hi; ++i) segment(i);
+            if (lo == hi) b.put("none\n");
+        } else if (cmd == "segments") {
+            std::string name;
+            q >> name;
+            auto [lo, hi] = q >> t1 >> t2 ? index.segmentsOf(name, t1, t2) : index.segmentsOf(name);
+            for (auto p = lo; p != hi; ++p) segment(*p);
+            if (lo == hi) b.put("none\n");
+        } else {
+            b.put("? ").put(line).put('\n');
+        }
+        b.put('\n');
+        b.flush();
+        out.flush();
+    }
+}
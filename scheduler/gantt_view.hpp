@@ -0,0 +1,148 @@
+// gantt_view.hpp
+// Downsampled Gantt view for schedules too long to print segment by segment.
+// The time range is cut into a fixed number of buckets (terminal columns or
+// SVG pixels); each bucket keeps its utilization and the process that held
+// the CPU longest in it. Buckets are filled in one pass over the segments in
+// time order, with only the current bucket's per-process totals in memory.
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "results.hpp"
+
+class GanttView {
+public:
+    struct Bucket {
+        double busy = 0;           // CPU time in the bucket
+        std::string_view dominant; // process with the most CPU time, empty when idle
+        double dominant_time = 0;
+    };
+
+    // Covers [t0, t1) in `width` buckets.
+    GanttView(std::int64_t t0, std::int64_t t1, std::size_t width)
+        : from(t0), to(std::max(t1, t0 + 1)), buckets(std::max<std::size_t>(width, 1)) {}
+
+    // Segments must arrive in time order. Ids are not copied: they have to
+    // outlive the view.
+    void add(std::string_view id, std::int64_t start, std::int64_t duration) {
+        double a = std::max<double>(start, from), z = std::min<double>(start + duration, to);
+        if (a >= z || id == "IDLE") return;
+        std::size_t first = std::min(buckets.size() - 1, (std::size_t)((a - from) / bucketSpan()));
+        for (std::size_t i = first; i < buckets.size() && edge(i) < z; ++i) {
+            double overlap = std::min(z, edge(i + 1)) - std::max(a, edge(i));
+            if (overlap <= 0) continue;
+            if (i != cur) { close(); cur = i; }
+            buckets[i].busy += overlap;
+            share[id] += overlap;
+        }
+    }
+
+    // Closes the last bucket; returns the buckets.
+    const std::vector<Bucket>& finish() {
+        close();
+        return buckets;
+    }
+
+    std::int64_t begin() const { return from; }
+    std::int64_t end() const { return to; }
+    double bucketSpan() const { return (double)(to - from) / buckets.size(); }
+
+private:
+    std::int64_t from, to;
+    std::vector<Bucket> buckets;
+    std::size_t cur = 0;
+    std::unordered_map<std::string_view, double> share;   // current bucket only
+
+    double edge(std::size_t i) const { return from + (double)(to - from) * i / buckets.size(); }
+
+    void close() {
+        Bucket& b = buckets[cur];
+        for (const auto& [id, t] : share)
+            if (t > b.dominant_time) { b.dominant_time = t; b.dominant = id; }
+        share.clear();
+    }
+};
+
+// Two text rows under a header naming the range: the dominant process per
+// column, coded by the legend below them, and utilization as a density ramp.
+inline void renderGanttText(std::ostream& out, GanttView& view) {
+    const auto& buckets = view.finish();
+    static const char kCodes[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789";
+    static const char kRamp[] = " .:-=+*#%@";
+    // Codes go to the processes that dominate the most columns.
+    std::unordered_map<std::string_view, std::size_t> columns;
+    for (const auto& b : buckets) if (!b.dominant.empty()) ++columns[b.dominant];
+    std::vector<std::pair<std::string_view, std::size_t>> order(columns.begin(), columns.end());
+    std::sort(order.begin(), order.end(), [](const auto& a, const auto& b) {
+        return a.second != b.second ? a.second > b.second : a.first < b.first;
+    });
+    std::unordered_map<std::string_view, char> code;
+    for (std::size_t i = 0; i < order.size() && i + 1 < sizeof kCodes; ++i) code[order[i].first] = kCodes[i];
+
+    OutBuffer b(out);
+    double span = view.bucketSpan();
+    b.put("Gantt [").num((long long)view.begin()).put(", ").num((long long)view.end()).put(") ")
+     .num((long long)buckets.size()).put(" columns of ").num6(span).put(" time units\n");
+    b.put("proc |");
+    for (const auto& k : buckets) {
+        if (k.dominant.empty()) b.put(' ');
+        else { auto it = code.find(k.dominant); b.put(it == code.end() ? '?' : it->second); }
+    }
+    b.put("|\nutil |");
+    for (const auto& k : buckets) {
+        int level = (int)(k.busy / span * (sizeof kRamp - 2) + 0.5);
+        b.put(kRamp[std::clamp(level, 0, (int)sizeof kRamp - 2)]);
+    }
+    b.put("|\n");
+    for (std::size_t i = 0; i < order.size() && i + 1 < sizeof kCodes; ++i)
+        b.put(i ? "  " : "").put(kCodes[i]).put('=').put(order[i].first);
+    if (order.size() + 1 > sizeof kCodes) b.put("  ?=other");
+    b.put('\n');
+}
+
+inline void xmlText(OutBuffer& b, std::string_view s) {
+    for (char c : s) {
+        if (c == '<') b.put("&lt;");
+        else if (c == '>') b.put("&gt;");
+        else if (c == '&') b.put("&amp;");
+        else b.put(c);
+    }
+}
+
+// One bar per bucket coloured by its dominant process, with a utilization
+// band underneath; hovering a bar shows its range, process and utilization.
+inline void renderGanttSvg(std::ostream& out, GanttView& view) {
+    const auto& buckets = view.finish();
+    const int bar = 40, band = 20;
+    double span = view.bucketSpan();
+    OutBuffer b(out);
+    b.put("<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"").num((long long)buckets.size())
+     .put("\" height=\"").num((long long)(bar + band + 20)).put("\" shape-rendering=\"crispEdges\">\n");
+    for (std::size_t i = 0; i < buckets.size(); ++i) {
+        const auto& k = buckets[i];
+        double util = k.busy / span;
+        if (!k.dominant.empty()) {
+            // Stable colour per id.
+            std::size_t h = std::hash<std::string_view>()(k.dominant);
+            b.put("<rect x=\"").num((long long)i).put("\" y=\"0\" width=\"1\" height=\"").num((long long)bar)
+             .put("\" fill=\"hsl(").num((long long)(h % 360)).put(",65%,50%)\"><title>");
+            xmlText(b, k.dominant);
+            b.put(" ").num6(view.begin() + i * span).put("-").num6(view.begin() + (i + 1) * span)
+             .put(" util ").num6(util * 100).put("%</title></rect>\n");
+        }
+        long long h = (long long)(util * band + 0.5);
+        if (h > 0)
+            b.put("<rect x=\"").num((long long)i).put("\" y=\"").num((long long)(bar + band - h))
+             .put("\" width=\"1\" height=\"").num(h).put("\" fill=\"#444\"/>\n");
+    }
+    b.put("<text x=\"0\" y=\"").num((long long)(bar + band + 15)).put("\" font-size=\"12\">")
+     .num((long long)view.begin()).put("</text>\n<text x=\"").num((long long)buckets.size())
+     .put("\" y=\"").num((long long)(bar + band + 15)).put("\" font-size=\"12\" text-anchor=\"end\">")
+     .num((long long)view.end()).put("</text>\n</svg>\n");
+}
@@ -0,0 +1,230 @@
+// generate.hpp
+// Synthetic workloads at scale, written straight to the workload file
+// format ("ID ARRIVAL BURST PRIORITY" lines, sorted by arrival).
+//
+// Arrivals are a Poisson process or a two-state MMPP (quiet and busy rates,
+// each state lasting an exponential time with its own mean), optionally
+// shaped by a diurnal curve that scales the rate by 1 - A cos(2 pi t / P):
+// lowest at t = 0, highest half a period later, 1 on average. Bursts come
+// from any io.hpp distribution, including paretoA-XM and lognormM-S for
+// heavy tails; priorities are uniform in 1..5. A target utilization rescales
+// the arrival rate so that rate * mean burst = utilization * CPUs.
+//
+// Jobs are generated in chunks on several threads. Every chunk draws from
+// its own splitmix64 streams, seeded by hashing (seed, chunk, purpose), so
+// the trace depends only on the seed, never on the thread count. Arrival
+// times are drawn as a unit-rate Poisson process (sums of Exp(1) gaps) and
+// then mapped onto real time through the inverse of the cumulative rate:
+// the first pass sums each chunk's gaps to find where it starts, the second
+// redraws them from the same stream and writes the jobs. The MMPP's state
+// changes, a few per thousands of jobs, are laid out sequentially in
+// between; they run on the diurnal clock.
+#pragma once
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "io.hpp"
+#include "smp.hpp"
+
+struct GenOptions {
+    long long jobs = 10;
+    bool mmpp = false;
+    double rate = 1;                        // Poisson; the MMPP's quiet state
+    double busy_rate = 1;                   // MMPP busy state
+    double quiet_dwell = 1000, busy_dwell = 1000;   // mean time in each state
+    io_detail::Dist burst{io_detail::Dist::Exp, 10, 0};
+    double diurnal_period = 0;              // 0: flat
+    double diurnal_amplitude = 0;           // in [0, 1)
+    double utilization = 0;                 // 0: rates as given
+    int cpus = 1;
+    std::uint64_t seed = 1;
+    int threads = 1;
+    long long chunk = 1 << 18;              // jobs per chunk
+};
+
+// "poisson:RATE" or "mmpp:QUIET:BUSY:QUIET_DWELL:BUSY_DWELL".
+inline bool parseArrivals(const std::string& s, GenOptions& o) {
+    std::istringstream in(s);
+    std::string kind;
+    std::getline(in, kind, ':');
+    std::vector<double> v;
+    for (std::string f; std::getline(in, f, ':');) {
+        char* end = nullptr;
+        v.push_back(std::strtod(f.c_str(), &end));
+        if (f.empty() || *end || v.back() <= 0) return false;
+    }
+    if (kind == "poisson" && v.size() == 1) { o.mmpp = false; o.rate = v[0]; return true; }
+    if (kind == "mmpp" && v.size() == 4) {
+        o.mmpp = true;
+        o.rate = v[0]; o.busy_rate = v[1]; o.quiet_dwell = v[2]; o.busy_dwell = v[3];
+        return true;
+    }
+    return false;
+}
+
+// "PERIOD:AMPLITUDE".
+inline bool parseDiurnal(const std::string& s, GenOptions& o) {
+    char* end = nullptr;
+    o.diurnal_period = std::strtod(s.c_str(), &end);
+    if (*end != ':') return false;
+    o.diurnal_amplitude = std::strtod(end + 1, &end);
+    return !*end && o.diurnal_period > 0 && o.diurnal_amplitude >= 0 && o.diurnal_amplitude < 1;
+}
+
+namespace gen_detail {
+
+enum Purpose : std::uint64_t { Gaps, Jobs, States, Mean };
+
+inline std::uint64_t stream(std::uint64_t seed, std::uint64_t chunk, Purpose p) {
+    std::uint64_t s = seed ^ (chunk * 4 + p) * 0xd1b54a32d192ed03ULL;
+    return io_detail::nextRandom(s);
+}
+
+inline double expGap(std::uint64_t& state) { return -std::log1p(-io_detail::uniform01(state)); }
+
+// Mean of the integer bursts drawn from `d`; 0 when it has none.
+inline double meanBurst(const io_detail::Dist& d, std::uint64_t seed) {
+    if (d.kind == io_detail::Dist::Pareto)   // too heavy-tailed to sample; +0.5 for the rounding up
+        return d.a > 1 ? d.a * d.b / (d.a - 1) + 0.5 : 0;
+    std::uint64_t state = stream(seed, 0, Mean);
+    double sum = 0;
+    const int n = 1 << 20;
+    for (int i = 0; i < n; ++i) sum += io_detail::draw(d, state);
+    return sum / n;
+}
+
+// Maps operational time (unit-rate arrivals) to real time.
+class Clock {
+    double rate = 1;
+    // MMPP: segment k starts at u_at[k] on the diurnal clock and s_at[k] in
+    // operational time, with rate rates[k].
+    std::vector<double> u_at, s_at, rates;
+    double period = 0, amplitude = 0;
+
+    // Diurnal clock: D(t) = t - A P / 2pi sin(2pi t / P), the integral of the
+    // rate multiplier. Newton from u, kept inside the bracket D allows.
+    double realTime(double u) const {
+        if (period <= 0 || amplitude <= 0) return u;
+        double w = io_detail::kTwoPi / period, r = amplitude / w;
+        double lo = u - r, hi = u + r, t = u;
+        for (int it = 0; it < 50; ++it) {
+            double f = t - r * std::sin(w * t) - u;
+            if (std::fabs(f) < 1e-9 * std::max(1.0, std::fabs(u))) break;
+            if (f > 0) hi = t; else lo = t;
+            double next = t - f / (1 - amplitude * std::cos(w * t));
+            t = next > lo && next < hi ? next : (lo + hi) / 2;
+        }
+        return t;
+    }
+
+public:
+    // Lays out MMPP states far enough to cover operational time `total`.
+    Clock(const GenOptions& o, double scale, double total)
+        : period(o.diurnal_period), amplitude(o.diurnal_amplitude) {
+        rate = o.rate * scale;
+        if (!o.mmpp) return;
+        std::uint64_t state = stream(o.seed, 0, States);
+        double u = 0, s = 0;
+        for (bool busy = false; s <= total; busy = !busy) {
+            double r = (busy ? o.busy_rate : o.rate) * scale;
+            double len = (busy ? o.busy_dwell : o.quiet_dwell) * expGap(state);
+            u_at.push_back(u); s_at.push_back(s); rates.push_back(r);
+            u += len;
+            s += len * r;
+        }
+    }
+
+    // Index of the MMPP segment holding operational time s, searching on
+    // from `hint`.
+    std::size_t segment(double s, std::size_t hint) const {
+        if (hint + 1 < s_at.size() && s_at[hint + 1] > s && s_at[hint] <= s) return hint;
+        return (std::size_t)(std::upper_bound(s_at.begin(), s_at.end(), s) - s_at.begin()) - 1;
+    }
+
+    double at(double s, std::size_t& hint) const {
+        if (rates.empty()) return realTime(s / rate);
+        hint = segment(s, hint);
+        return realTime(u_at[hint] + (s - s_at[hint]) / rates[hint]);
+    }
+};
+
+} // namespace gen_detail
+
+// Writes o.jobs jobs to `out`; false with `error` set when the options
+// cannot be met.
+inline bool generateWorkload(const GenOptions& o, std::ostream& out, std::string& error) {
+    using namespace gen_detail;
+    if (o.jobs < 0) { error = "Job count must not be negative"; return false; }
+    double scale = 1;
+    if (o.utilization > 0) {
+        double mean = meanBurst(o.burst, o.seed);
+        if (mean <= 0) { error = "Burst distribution has no finite mean to target a utilization with"; return false; }
+        double rate = o.mmpp ? (o.rate * o.quiet_dwell + o.busy_rate * o.busy_dwell) / (o.quiet_dwell + o.busy_dwell)
+                             : o.rate;
+        scale = o.utilization * std::max(1, o.cpus) / mean / rate;
+    }
+
+    const long long chunk = std::max(1LL, o.chunk);
+    const long long chunks = (o.jobs + chunk - 1) / chunk;
+    const int parts = (int)std::max(1LL, std::min<long long>(std::max(1, o.threads), chunks));
+    WindowWorkers workers(parts);
+    auto jobsIn = [&](long long k) { return std::min(chunk, o.jobs - k * chunk); };
+
+    // Pass 1: where every chunk starts in operational time.
+    std::vector<double> start(chunks + 1, 0.0);
+    for (long long base = 0; base < chunks; base += parts)
+        workers.run([&](int w) {
+            long long k = base + w;
+            if (k >= chunks) return;
+            std::uint64_t state = stream(o.seed, (std::uint64_t)k, Gaps);
+            double acc = 0;
+            for (long long j = jobsIn(k); j > 0; --j) acc += expGap(state);
+            start[k + 1] = acc;
+        });
+    for (long long k = 0; k < chunks; ++k) start[k + 1] += start[k];
+
+    Clock clock(o, scale, start[chunks]);
+    std::size_t hint = 0;
+    if (chunks > 0 && clock.at(start[chunks], hint) >= (double)kMaxSimTime) {
+        error = "Trace would run past the largest arrival time; use fewer jobs or a higher rate";
+        return false;
+    }
+
+    // Pass 2: jobs, formatted per chunk and written in order.
+    std::vector<std::string> text(parts);
+    for (long long base = 0; base < chunks; base += parts) {
+        workers.run([&](int w) {
+            long long k = base + w;
+            std::string& buf = text[w];
+            buf.clear();
+            if (k >= chunks) return;
+            std::uint64_t gaps = stream(o.seed, (std::uint64_t)k, Gaps), jobs = stream(o.seed, (std::uint64_t)k, Jobs);
+            std::size_t seg = 0;
+            double acc = 0;
+            auto field = [&](long long v, char sep) {
+                char tmp[24];
+                buf.append(tmp, std::to_chars(tmp, tmp + sizeof tmp, v).ptr);
+                buf += sep;
+            };
+            for (long long j = 0, n = jobsIn(k); j < n; ++j) {
+                acc += expGap(gaps);
+                long long arrival = (long long)clock.at(start[k] + acc, seg);
+                SimTime burst = io_detail::draw(o.burst, jobs);
+                int priority = 1 + (int)(io_detail::nextRandom(jobs) % 5);
+                buf += 'P';
+                field(k * chunk + j + 1, ' ');
+                field(arrival, ' ');
+                field(burst, ' ');
+                field(priority, '\n');
+            }
+        });
+        for (const std::string& buf : text) out.write(buf.data(), (std::streamsize)buf.size());
+    }
+    return (bool)out;
+}
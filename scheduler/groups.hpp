@@ -0,0 +1,181 @@
+// groups.hpp
+// Scheduling groups for CFS, nested like cgroups. Every group has a weight
+// (1024 by default) and splits the CPU time its parent gives it between its
+// own processes and subgroups. Groups are declared in the workload file,
+//   group PATH [WEIGHT]          e.g. group tenantA/web 512
+// and processes join one with a group=PATH field on their line. Missing
+// parent groups are created with the default weight; processes without a
+// group belong to the root.
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+#include "results.hpp"
+
+class GroupTree {
+public:
+    static constexpr int kDefaultWeight = 1024;
+
+    struct Group {
+        std::string path;
+        int parent;        // -1 for the root
+        int weight;
+        int depth;
+    };
+
+    GroupTree() { groups.push_back({"", -1, kDefaultWeight, 0}); }
+
+    bool empty() const { return groups.size() == 1; }
+    std::size_t size() const { return groups.size(); }
+    const Group& operator[](int g) const { return groups[g]; }
+
+    // Index of PATH, creating it and its parents as needed.
+    int find(const std::string& path) {
+        int g = 0;
+        std::size_t from = 0;
+        while (from < path.size()) {
+            std::size_t slash = path.find('/', from);
+            if (slash == std::string::npos) slash = path.size();
+            if (slash > from) {
+                std::string prefix = path.substr(0, slash);
+                int child = -1;
+                for (std::size_t i = 1; i < groups.size() && child < 0; ++i)
+                    if (groups[i].parent == g && groups[i].path == prefix) child = (int)i;
+                if (child < 0) {
+                    groups.push_back({prefix, g, kDefaultWeight, groups[g].depth + 1});
+                    child = (int)groups.size() - 1;
+                }
+                g = child;
+            }
+            from = slash + 1;
+        }
+        return g;
+    }
+
+    // "group PATH [WEIGHT]"; false when malformed.
+    bool declare(std::istringstream& line) {
+        std::string path;
+        int weight = kDefaultWeight;
+        if (!(line >> path)) return false;
+        if (line >> weight && weight < 1) return false;
+        int g = find(path);
+        if (g == 0) return false;
+        groups[g].weight = weight;
+        return true;
+    }
+
+private:
+    std::vector<Group> groups;
+};
+
+// CPU time, waiting and turnaround per group, subgroups included. The CPU
+// time is what the group's processes got in the run's charts, `cpus` of them
+// from `tracks` on; the part of it taken while the group was contended, with
+// one of its processes and a process of its parent outside it both between
+// arrival and completion, against what the parent got over the same time,
+// is the share that shows how well tenants are isolated. `capacity` is the
+// CPU time the run had over all CPUs.
+template <class ProcTable, class Chart>
+void printGroupReport(std::ostream& out, const GroupTree& tree, const ProcTable& procs,
+                      const Chart* tracks, std::size_t cpus, long long capacity) {
+    struct Totals {
+        std::uint64_t n = 0;
+        long long wait = 0, turn = 0;
+        long long active = 0;             // processes between arrival and completion
+        int running = 0;                  // CPUs running one of them
+        long long cpu = 0, at = 0;        // CPU time up to `at`
+        bool contended = false;
+        long long since = 0, cpu_from = 0, parent_from = 0;
+        long long contended_time = 0, contended_cpu = 0, parent_cpu = 0;
+    };
+    int groups = (int)tree.size();
+    std::vector<Totals> sum(groups);
+    std::vector<std::vector<int>> children(groups);
+    for (int g = 1; g < groups; ++g) children[tree[g].parent].push_back(g);
+    std::unordered_map<std::string, int> group_of;
+    group_of.reserve(procs.size());
+    // (time, kind, group): kinds 0/1 stop/start running, 2/3 complete/arrive
+    std::vector<std::tuple<long long, int, int>> events;
+    events.reserve(procs.size() * 2);
+    for (const auto& p : procs) {
+        int leaf = p.group < 0 ? 0 : p.group;
+        group_of.emplace(p.id, leaf);
+        events.emplace_back((long long)p.arrival_time, 3, leaf);
+        events.emplace_back((long long)p.arrival_time + p.turnaround_time, 2, leaf);
+        for (int g = leaf; g >= 0; g = tree[g].parent) {
+            ++sum[g].n;
+            sum[g].wait += p.waiting_time;
+            sum[g].turn += p.turnaround_time;
+        }
+    }
+    for (std::size_t c = 0; c < cpus; ++c) {
+        long long t = 0;
+        for (const auto& e : tracks[c]) {
+            auto it = group_of.find(e.first);
+            if (it != group_of.end() && e.second > 0) {
+                events.emplace_back(t, 1, it->second);
+                events.emplace_back(t + e.second, 0, it->second);
+            }
+            t += e.second;
+        }
+    }
+    std::sort(events.begin(), events.end());
+
+    auto advance = [&](int g, long long t) {
+        Totals& s = sum[g];
+        s.cpu += s.running * (t - s.at);
+        s.at = t;
+    };
+    auto recheck = [&](int g, long long t) {
+        Totals& s = sum[g];
+        const Totals& parent = sum[tree[g].parent];
+        bool contended = s.active > 0 && parent.active > s.active;
+        if (contended == s.contended) return;
+        advance(g, t);
+        advance(tree[g].parent, t);
+        if (contended) {
+            s.since = t;
+            s.cpu_from = s.cpu;
+            s.parent_from = parent.cpu;
+        } else {
+            s.contended_time += t - s.since;
+            s.contended_cpu += s.cpu - s.cpu_from;
+            s.parent_cpu += parent.cpu - s.parent_from;
+        }
+        s.contended = contended;
+    };
+    long long end = 0;
+    for (const auto& [t, kind, leaf] : events) {
+        end = std::max(end, t);
+        if (kind < 2) {
+            for (int g = leaf; g >= 0; g = tree[g].parent) {
+                advance(g, t);
+                sum[g].running += kind ? 1 : -1;
+            }
+            continue;
+        }
+        for (int g = leaf; g >= 0; g = tree[g].parent) sum[g].active += kind == 3 ? 1 : -1;
+        // Only the groups on the path, their siblings and the leaf's subgroups can change
+        for (int g = leaf; g >= 0; g = tree[g].parent)
+            for (int child : children[g]) recheck(child, t);
+    }
+    for (int g = 0; g < groups; ++g) advance(g, end);
+
+    OutBuffer b(out);
+    for (int g = 1; g < groups; ++g) {
+        const Totals& s = sum[g];
+        b.put("Group ").put(tree[g].path).put(": weight ").num((long long)tree[g].weight)
+         .put(", processes ").num((long long)s.n).put(", CPU time ").num(s.cpu)
+         .put(" (").num6(capacity > 0 ? 100.0 * s.cpu / capacity : 0).put("% of run), contended ")
+         .num(s.contended_time).put(" with ")
+         .num6(s.parent_cpu > 0 ? 100.0 * s.contended_cpu / s.parent_cpu : 0).put("% of parent, avg waiting ")
+         .num6(s.n ? (double)s.wait / s.n : 0).put(", avg turnaround ").num6(s.n ? (double)s.turn / s.n : 0)
+         .put('\n');
+    }
+}
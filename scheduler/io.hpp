@@ -0,0 +1,415 @@
+// io.hpp
+// I/O model. A process with I/O runs as phases: a CPU burst followed by a
+// request to a device, then the next CPU burst, ending on a CPU burst without
+// I/O. Devices serve one request at a time from their own queue, first come
+// first served or by elevator (sweeping up the tracks and back, serving the
+// nearest request in the current direction). A request takes its own service
+// time plus seek time for the distance the head moves.
+//
+// A process's phases come from a generator that produces the next one only
+// when the current CPU burst is over, so a service running for millions of
+// phases costs a few words while it is active and nothing before or after.
+// Generators run a compact program: a script with repeat groups, or
+// distributions to draw bursts from.
+//
+// Workload syntax, alongside the usual process lines:
+//   device NAME fifo|elevator [SEEK]      SEEK: time per 100 tracks moved
+//   ID ARRIVAL BURST PRIORITY [DEADLINE] PROGRAM
+// PROGRAM is either a script alternating CPU bursts and requests
+// (device:service[@track]), with (...)*N repeating a group, e.g.
+//   4,(disk:5@120,3)*1000,net:2,6
+// or random:PHASES:CPU:DEVICE:SERVICE, drawing CPU bursts and service
+// times from N (constant), expM (exponential, mean M), uniA-B,
+// paretoA-XM (shape A, minimum XM) or lognormM-S (median M, log-space
+// standard deviation S), e.g.
+//   random:50000:exp4:disk:uni2-8
+// A script's CPU bursts replace the burst column; for random programs the
+// column is an estimate until the process completes. Devices named only in
+// programs are FIFO without seek time.
+#pragma once
+#include <algorithm>
+#include <cctype>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "sim_time.hpp"
+
+struct IoPhase {
+    SimTime cpu = 0;        // CPU burst
+    int device = -1;        // request after the burst, -1 on the last phase
+    SimTime service = 0;
+    int track = 0;
+};
+
+struct IoDevice {
+    std::string name;
+    bool elevator = false;
+    int seek = 0;
+};
+
+// A process's phases, one at a time.
+class PhaseGenerator {
+protected:
+    IoPhase cur;
+    long long cpu_total = 0;
+public:
+    virtual ~PhaseGenerator() = default;
+    const IoPhase& phase() const { return cur; }
+    // CPU time of the phases produced so far.
+    long long total() const { return cpu_total; }
+    // Moves to the next phase; false when there is none.
+    virtual bool advance() = 0;
+};
+
+namespace io_detail {
+
+// Script step; a group is Repeat ... End.
+struct Op {
+    enum Kind { Cpu, Io, Repeat, End } kind;
+    long long a = 0, b = 0, c = 0;   // Cpu: burst; Io: device, service, track; Repeat: count
+};
+
+// Burst length distribution.
+struct Dist {
+    enum Kind { Const, Exp, Uniform, Pareto, Lognormal } kind = Const;
+    double a = 1, b = 1;
+};
+
+inline bool parseDist(const std::string& s, Dist& d) {
+    char* end = nullptr;
+    for (auto [name, kind] : {std::pair<const char*, Dist::Kind>{"pareto", Dist::Pareto}, {"lognorm", Dist::Lognormal}}) {
+        std::size_t len = std::char_traits<char>::length(name);
+        if (s.compare(0, len, name) != 0) continue;
+        d.kind = kind;
+        d.a = std::strtod(s.c_str() + len, &end);
+        if (*end != '-') return false;
+        d.b = std::strtod(end + 1, &end);
+        return !*end && d.a > 0 && d.b > 0;
+    }
+    if (s.compare(0, 3, "exp") == 0) {
+        d = {Dist::Exp, std::strtod(s.c_str() + 3, &end), 0};
+        return !*end && d.a > 0;
+    }
+    if (s.compare(0, 3, "uni") == 0) {
+        d.kind = Dist::Uniform;
+        d.a = std::strtod(s.c_str() + 3, &end);
+        if (*end != '-') return false;
+        d.b = std::strtod(end + 1, &end);
+        return !*end && d.a >= 1 && d.b >= d.a;
+    }
+    d = {Dist::Const, std::strtod(s.c_str(), &end), 0};
+    return end != s.c_str() && !*end && d.a >= 1;
+}
+
+// splitmix64: eight bytes of state per generator.
+inline std::uint64_t nextRandom(std::uint64_t& state) {
+    std::uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+constexpr double kTwoPi = 6.283185307179586;
+
+inline double uniform01(std::uint64_t& state) { return (nextRandom(state) >> 11) * 0x1.0p-53; }
+
+inline SimTime draw(const Dist& d, std::uint64_t& state) {
+    double u = uniform01(state), v = d.a;
+    switch (d.kind) {
+        case Dist::Exp:       v = -d.a * std::log1p(-u); break;
+        case Dist::Uniform:   v = d.a + std::floor(u * (d.b - d.a + 1)); break;
+        case Dist::Pareto:    v = d.b * std::pow(1 - u, -1 / d.a); break;
+        case Dist::Lognormal: // Box-Muller
+            v = d.a * std::exp(d.b * std::sqrt(-2 * std::log1p(-u)) * std::cos(kTwoPi * uniform01(state)));
+            break;
+        case Dist::Const:     break;
+    }
+    v = std::ceil(v);
+    return v >= (double)kMaxSimTime ? kMaxSimTime : (SimTime)std::max(1.0, v);
+}
+
+// Recursive descent over a script, checking that CPU bursts and requests
+// alternate however the groups repeat. `first`/`last` report the kind of
+// the list's first and last item.
+class ScriptParser {
+    const std::string& s;
+    std::size_t pos = 0;
+    std::vector<Op>& ops;
+    std::vector<std::string>& names;
+
+    // At most `limit`; times up to kMaxSimTime, counts and tracks up to INT_MAX.
+    bool number(long long& v, long long limit = INT_MAX) {
+        std::size_t start = pos;
+        while (pos < s.size() && std::isdigit((unsigned char)s[pos])) ++pos;
+        if (pos == start || pos - start > 18) return false;
+        v = std::stoll(s.substr(start, pos - start));
+        return v <= limit;
+    }
+
+    bool item(Op::Kind& first, Op::Kind& last, long long& cpu) {
+        if (pos < s.size() && s[pos] == '(') {
+            ++pos;
+            std::size_t open = ops.size();
+            ops.push_back({Op::Repeat});
+            long long body = 0, count = 0;
+            if (!list(first, last, body) || pos + 1 >= s.size() || s[pos] != ')' || s[pos + 1] != '*') return false;
+            pos += 2;
+            if (!number(count) || count < 1 || (count > 1 && first == last)) return false;
+            ops[open].a = count;
+            ops.push_back({Op::End});
+            cpu += body > (LLONG_MAX / 2 - cpu) / count ? LLONG_MAX / 2 - cpu : body * count;
+            return true;
+        }
+        long long v = 0;
+        std::size_t start = pos;
+        if (number(v, kMaxSimTime) && (pos == s.size() || s[pos] == ',' || s[pos] == ')')) {
+            if (v < 1) return false;
+            ops.push_back({Op::Cpu, v});
+            cpu += v;
+            first = last = Op::Cpu;
+            return true;
+        }
+        pos = start;
+        std::size_t colon = s.find(':', pos);
+        std::size_t stop = s.find_first_of(",()", pos);
+        if (colon == std::string::npos || colon == pos || colon > stop) return false;
+        std::string name = s.substr(pos, colon - pos);
+        pos = colon + 1;
+        long long service = 0, track = 0;
+        if (!number(service, kMaxSimTime) || service < 1) return false;
+        if (pos < s.size() && s[pos] == '@' && (++pos, !number(track))) return false;
+        int dev = (int)(std::find(names.begin(), names.end(), name) - names.begin());
+        if (dev == (int)names.size()) names.push_back(name);
+        ops.push_back({Op::Io, dev, service, track});
+        first = last = Op::Io;
+        return true;
+    }
+
+public:
+    ScriptParser(const std::string& text, std::vector<Op>& out, std::vector<std::string>& devices)
+        : s(text), ops(out), names(devices) {}
+
+    bool list(Op::Kind& first, Op::Kind& last, long long& cpu) {
+        Op::Kind f, l;
+        if (!item(first, last, cpu)) return false;
+        while (pos < s.size() && s[pos] == ',') {
+            ++pos;
+            if (!item(f, l, cpu) || f == last) return false;
+            last = l;
+        }
+        return true;
+    }
+
+    bool done() const { return pos == s.size(); }
+};
+
+class ScriptPhases : public PhaseGenerator {
+    const std::vector<Op>& ops;
+    std::size_t pc = 0;
+    std::vector<std::pair<std::size_t, long long>> loops;   // (Repeat index, iterations left)
+
+    const Op* pull() {
+        while (pc < ops.size()) {
+            const Op& o = ops[pc];
+            if (o.kind == Op::Repeat) { loops.emplace_back(pc++, o.a); continue; }
+            if (o.kind == Op::End) {
+                if (--loops.back().second > 0) pc = loops.back().first + 1;
+                else { loops.pop_back(); ++pc; }
+                continue;
+            }
+            ++pc;
+            return &o;
+        }
+        return nullptr;
+    }
+
+public:
+    explicit ScriptPhases(const std::vector<Op>& program) : ops(program) {}
+
+    bool advance() override {
+        const Op* o = pull();
+        if (!o) return false;
+        cur = IoPhase{(SimTime)o->a};
+        cpu_total += o->a;
+        if (const Op* io = pull()) { cur.device = (int)io->a; cur.service = (SimTime)io->b; cur.track = (int)io->c; }
+        return true;
+    }
+};
+
+class RandomPhases : public PhaseGenerator {
+    long long left;
+    int device;
+    const Dist& cpu_d;
+    const Dist& service_d;
+    std::uint64_t state;
+
+public:
+    RandomPhases(long long phases, int dev, const Dist& c, const Dist& sv, std::uint64_t seed)
+        : left(phases), device(dev), cpu_d(c), service_d(sv), state(seed) {}
+
+    bool advance() override {
+        if (left == 0) return false;
+        cur = IoPhase{draw(cpu_d, state)};
+        cpu_total += cur.cpu;
+        if (--left > 0) { cur.device = device; cur.service = draw(service_d, state); }
+        return true;
+    }
+};
+
+} // namespace io_detail
+
+// Devices and phase programs of a workload; a process refers to its program
+// by Process::program.
+class IoWorkload {
+    struct Program {
+        std::vector<io_detail::Op> script;   // empty for a random program
+        long long phases = 0;
+        int device = -1;
+        io_detail::Dist cpu, service;
+    };
+    std::vector<Program> programs;
+
+public:
+    std::vector<IoDevice> devices;
+
+    bool empty() const { return programs.empty(); }
+
+    int device(const std::string& name) {
+        for (std::size_t d = 0; d < devices.size(); ++d) if (devices[d].name == name) return (int)d;
+        devices.push_back({name});
+        return (int)devices.size() - 1;
+    }
+
+    // "device NAME fifo|elevator [SEEK]"; false when malformed.
+    bool declare(std::istringstream& line) {
+        std::string name, kind;
+        int seek = 0;
+        if (!(line >> name >> kind) || (kind != "fifo" && kind != "elevator")) return false;
+        line >> seek;
+        IoDevice& d = devices[device(name)];
+        d.elevator = kind == "elevator";
+        d.seek = seek;
+        return true;
+    }
+
+    // Adds a program; returns its index, or -1 when malformed. A script's
+    // total CPU time replaces `cpu`.
+    int addProgram(const std::string& text, long long& cpu) {
+        Program p;
+        if (text.compare(0, 7, "random:") == 0) {
+            std::istringstream in(text.substr(7));
+            std::string n, c, dev, sv;
+            if (!std::getline(in, n, ':') || !std::getline(in, c, ':') || !std::getline(in, dev, ':') ||
+                !std::getline(in, sv) || dev.empty() || !io_detail::parseDist(c, p.cpu) ||
+                !io_detail::parseDist(sv, p.service))
+                return -1;
+            p.phases = std::atoll(n.c_str());
+            if (p.phases < 1) return -1;
+            p.device = device(dev);
+        } else {
+            std::vector<std::string> names;
+            io_detail::ScriptParser parser(text, p.script, names);
+            io_detail::Op::Kind first, last;
+            long long total = 0;
+            if (!parser.list(first, last, total) || !parser.done() ||
+                first != io_detail::Op::Cpu || last != io_detail::Op::Cpu)
+                return -1;
+            for (auto& op : p.script) if (op.kind == io_detail::Op::Io) op.a = device(names[op.a]);
+            cpu = total;
+        }
+        programs.push_back(std::move(p));
+        return (int)programs.size() - 1;
+    }
+
+    // A generator positioned on the first phase of `program`. Random
+    // programs are seeded by their index, so every run draws the same bursts.
+    std::unique_ptr<PhaseGenerator> start(int program) const {
+        const Program& p = programs[program];
+        std::unique_ptr<PhaseGenerator> g;
+        if (p.script.empty())
+            g = std::make_unique<io_detail::RandomPhases>(p.phases, p.device, p.cpu, p.service,
+                                                          0x5eed0000ULL + (std::uint64_t)program);
+        else
+            g = std::make_unique<io_detail::ScriptPhases>(p.script);
+        g->advance();
+        return g;
+    }
+};
+
+struct IoDeviceStats {
+    long long busy = 0;
+    std::uint64_t requests = 0;
+    long long queued = 0;             // time requests waited before service
+    std::size_t max_queue = 0;
+};
+
+// One device's queue and the request in service.
+class IoDeviceQueue {
+    struct Request { int proc; SimTime service; int track; long long since; };
+    const IoDevice* dev;
+    std::deque<Request> fifo;
+    std::map<std::pair<int, std::uint64_t>, Request> sweep;   // elevator, by (track, arrival order)
+    std::uint64_t seq = 0;
+    int head = 0;
+    bool up = true;
+
+    Request next() {
+        if (!dev->elevator) { Request r = fifo.front(); fifo.pop_front(); return r; }
+        auto it = sweep.lower_bound({head, 0});
+        if (up && it == sweep.end()) up = false;
+        if (!up) {
+            it = sweep.upper_bound({head, UINT64_MAX});
+            if (it == sweep.begin()) up = true;
+            else --it;
+        }
+        Request r = it->second;
+        sweep.erase(it);
+        return r;
+    }
+
+public:
+    IoDeviceStats stats;
+    int serving = -1;                 // process in service, -1 when idle
+    long long done_at = 0;
+
+    explicit IoDeviceQueue(const IoDevice& d) : dev(&d) {}
+
+    void submit(int proc, SimTime service, int track, long long now) {
+        Request r{proc, service, track, now};
+        if (dev->elevator) sweep.emplace(std::make_pair(track, seq++), r);
+        else fifo.push_back(r);
+        stats.max_queue = std::max(stats.max_queue, size());
+    }
+
+    // Starts the next request when idle; true if one started.
+    bool start(long long now) {
+        if (serving >= 0 || size() == 0) return false;
+        Request r = next();
+        long long seek = (long long)std::abs(r.track - head) * dev->seek / 100;
+        head = r.track;
+        serving = r.proc;
+        done_at = now + r.service + seek;
+        stats.busy += r.service + seek;
+        stats.queued += now - r.since;
+        ++stats.requests;
+        return true;
+    }
+
+    // Ends the request in service; returns its process.
+    int finish() {
+        int p = serving;
+        serving = -1;
+        return p;
+    }
+
+    std::size_t size() const { return dev->elevator ? sweep.size() : fifo.size(); }
+};
@@ -0,0 +1,168 @@
+// memory.hpp
+// Allocation accounting per subsystem. The containers the simulator lives in
+// (process table, Gantt chart, ready queues) use TrackingAllocator, which
+// tallies bytes and calls in the allocating thread's MemAccount. Every block
+// carries a small header naming that account, so a block freed on another
+// thread (a batch workload loaded by one worker and dropped by the main
+// thread) is debited where it was charged. Id strings keep the default
+// allocator; their heap use is measured from capacity when the report is
+// built.
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <new>
+#include <ostream>
+#include <queue>
+#include <set>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+
+enum class MemTag { ProcessTable, Gantt, ReadyQueue, Count };
+
+inline const char* memTagName(MemTag tag) {
+    switch (tag) {
+        case MemTag::ProcessTable: return "process_table";
+        case MemTag::Gantt:        return "gantt";
+        case MemTag::ReadyQueue:   return "ready_queues";
+        default:                   return "?";
+    }
+}
+
+struct MemTagStats {
+    long long bytes = 0;       // live bytes
+    long long peak = 0;        // high-water mark of `bytes`
+    std::uint64_t allocs = 0;
+    std::uint64_t frees = 0;
+};
+
+// Charged only by its own thread, which alone moves the peaks; frees may
+// come from any thread, hence the relaxed atomics.
+class MemAccount {
+    struct Tag {
+        std::atomic<long long> bytes{0}, peak{0};
+        std::atomic<std::uint64_t> allocs{0}, frees{0};
+    };
+    std::array<Tag, (size_t)MemTag::Count> tags;
+    std::atomic<long long> total{0}, total_peak{0};
+
+    static void raise(std::atomic<long long>& peak, long long now) {
+        if (now > peak.load(std::memory_order_relaxed)) peak.store(now, std::memory_order_relaxed);
+    }
+public:
+    void add(MemTag tag, std::size_t n) {
+        auto& s = tags[(size_t)tag];
+        raise(s.peak, s.bytes.fetch_add((long long)n, std::memory_order_relaxed) + (long long)n);
+        s.allocs.fetch_add(1, std::memory_order_relaxed);
+        raise(total_peak, total.fetch_add((long long)n, std::memory_order_relaxed) + (long long)n);
+    }
+    void sub(MemTag tag, std::size_t n) {
+        auto& s = tags[(size_t)tag];
+        s.bytes.fetch_sub((long long)n, std::memory_order_relaxed);
+        s.frees.fetch_add(1, std::memory_order_relaxed);
+        total.fetch_sub((long long)n, std::memory_order_relaxed);
+    }
+    // Starts a new measurement: peaks drop to what is live now, counts to zero.
+    void resetPeaks() {
+        for (auto& s : tags) { s.peak = s.bytes.load(); s.allocs = 0; s.frees = 0; }
+        total_peak = total.load();
+    }
+    MemTagStats operator[](MemTag tag) const {
+        const auto& s = tags[(size_t)tag];
+        return {s.bytes.load(), s.peak.load(), s.allocs.load(), s.frees.load()};
+    }
+    long long live() const { return total.load(); }
+    long long peak() const { return total_peak.load(); }
+};
+
+// One account per thread. Accounts are never freed, so a block outliving
+// the thread that allocated it can still be debited.
+inline MemAccount& memAccount() {
+    static thread_local MemAccount* account = new MemAccount;
+    return *account;
+}
+
+template <class T, MemTag Tag>
+struct TrackingAllocator {
+    using value_type = T;
+    template <class U> struct rebind { using other = TrackingAllocator<U, Tag>; };
+
+    TrackingAllocator() noexcept = default;
+    template <class U> TrackingAllocator(const TrackingAllocator<U, Tag>&) noexcept {}
+
+    // The owning account sits in a header ahead of the block.
+    static constexpr std::size_t kHeader = alignof(std::max_align_t);
+    static_assert(alignof(T) <= kHeader && sizeof(MemAccount*) <= kHeader, "over-aligned tracked type");
+
+    T* allocate(std::size_t n) {
+        if (n > (std::size_t(-1) - kHeader) / sizeof(T)) throw std::bad_array_new_length();
+        char* base = static_cast<char*>(::operator new(kHeader + n * sizeof(T)));
+        MemAccount& a = memAccount();
+        *reinterpret_cast<MemAccount**>(base) = &a;
+        a.add(Tag, n * sizeof(T));
+        return reinterpret_cast<T*>(base + kHeader);
+    }
+    void deallocate(T* p, std::size_t n) noexcept {
+        char* base = reinterpret_cast<char*>(p) - kHeader;
+        (*reinterpret_cast<MemAccount**>(base))->sub(Tag, n * sizeof(T));
+        ::operator delete(base);
+    }
+    template <class U> bool operator==(const TrackingAllocator<U, Tag>&) const noexcept { return true; }
+    template <class U> bool operator!=(const TrackingAllocator<U, Tag>&) const noexcept { return false; }
+};
+
+// Scheduler-internal containers: ready queues, heaps and per-run bookkeeping.
+template <class T> using ReadyVector = std::vector<T, TrackingAllocator<T, MemTag::ReadyQueue>>;
+template <class T> using ReadyQueue = std::queue<T, std::deque<T, TrackingAllocator<T, MemTag::ReadyQueue>>>;
+template <class T, class Cmp> using ReadyHeap = std::priority_queue<T, ReadyVector<T>, Cmp>;
+template <class T> using ReadySet = std::set<T, std::less<T>, TrackingAllocator<T, MemTag::ReadyQueue>>;
+
+// Heap bytes behind a string; short ids live in the small-string buffer.
+inline std::size_t stringHeapBytes(const std::string& s) {
+    static const std::size_t inline_capacity = std::string().capacity();
+    return s.capacity() > inline_capacity ? s.capacity() + 1 : 0;
+}
+
+inline long peakRssKb() {
+    struct rusage ru {};
+    getrusage(RUSAGE_SELF, &ru);
+    return ru.ru_maxrss;
+}
+
+// End-of-run report. `procs` and `gantt` are the run's process table and
+// Gantt chart, scanned for id-string heap use.
+template <class ProcTable, class Chart>
+void printMemoryReport(std::ostream& out, bool json, const ProcTable& procs, const Chart& gantt) {
+    const MemAccount& a = memAccount();
+    std::size_t proc_str = 0, proc_str_allocs = 0, gantt_str = 0, gantt_str_allocs = 0;
+    for (const auto& p : procs) if (std::size_t b = stringHeapBytes(p.id)) { proc_str += b; ++proc_str_allocs; }
+    for (const auto& e : gantt) if (std::size_t b = stringHeapBytes(e.first)) { gantt_str += b; ++gantt_str_allocs; }
+    double per_proc = procs.empty() ? 0
+        : (double)(procs.capacity() * sizeof(procs[0]) + proc_str) / procs.size();
+    double per_seg = gantt.empty() ? 0
+        : (double)(gantt.capacity() * sizeof(gantt[0]) + gantt_str) / gantt.size();
+    const MemTag tags[] = {MemTag::ProcessTable, MemTag::Gantt, MemTag::ReadyQueue};
+
+    if (json) {
+        out << "{\"peak_rss_kb\": " << peakRssKb() << ", \"tracked_peak_bytes\": " << a.peak();
+        for (MemTag t : tags)
+            out << ", \"" << memTagName(t) << "\": {\"peak_bytes\": " << a[t].peak << ", \"live_bytes\": "
+                << a[t].bytes << ", \"allocs\": " << a[t].allocs << ", \"frees\": " << a[t].frees << "}";
+        out << ", \"id_strings\": {\"bytes\": " << proc_str + gantt_str
+            << ", \"allocs\": " << proc_str_allocs + gantt_str_allocs << "}"
+            << ", \"bytes_per_process\": " << per_proc
+            << ", \"bytes_per_gantt_segment\": " << per_seg << "}\n";
+        return;
+    }
+    out << "Memory: peak RSS " << peakRssKb() << " kB, tracked peak " << a.peak() << " bytes\n";
+    for (MemTag t : tags)
+        out << "  " << memTagName(t) << ": peak " << a[t].peak << " bytes, live " << a[t].bytes
+            << " bytes, " << a[t].allocs << " allocs, " << a[t].frees << " frees\n";
+    out << "  id_strings: " << proc_str + gantt_str << " heap bytes in "
+        << proc_str_allocs + gantt_str_allocs << " allocs\n";
+    out << "  per process: " << per_proc << " bytes, per Gantt segment: " << per_seg << " bytes\n";
+}
@@ -0,0 +1,222 @@
+// metrics.hpp
+// Single-pass run metrics. Schedulers feed a MetricsAccumulator from their
+// first-dispatch and completion events; means come from running sums and
+// percentiles from log-linear histograms, so memory stays bounded however
+// many processes run, and accumulators from separate runs can be merged.
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <ostream>
+#include <tuple>
+#include <vector>
+
+// HDR-style histogram: values below 2^kPrecisionBits are exact, larger values
+// land in one of 2^kPrecisionBits sub-buckets of their power of two, which
+// bounds the relative error of any reported value by 2^-kPrecisionBits.
+// Negative values (possible for schedulers that ignore arrival times) are
+// kept in a mirrored set of buckets.
+class LogHistogram {
+    static constexpr int kPrecisionBits = 7;
+    static constexpr std::int64_t kSub = std::int64_t(1) << kPrecisionBits;
+    std::vector<std::uint64_t> pos, neg;
+    std::uint64_t total = 0;
+
+    static std::size_t bucketOf(std::uint64_t v) {
+        if (v < (std::uint64_t)kSub) return (std::size_t)v;
+        int msb = 63 - __builtin_clzll(v);
+        int shift = msb - kPrecisionBits;
+        return (std::size_t)(kSub + shift * kSub + (std::int64_t)(v >> shift) - kSub);
+    }
+    // Midpoint of the values that share bucket `i`.
+    static double valueOf(std::size_t i) {
+        if ((std::int64_t)i < kSub) return (double)i;
+        std::int64_t shift = (std::int64_t)i / kSub - 1;
+        std::int64_t lo = ((std::int64_t)i % kSub + kSub) << shift;
+        return lo + ((std::int64_t(1) << shift) - 1) / 2.0;
+    }
+    static void add(std::vector<std::uint64_t>& b, std::uint64_t v, std::uint64_t n) {
+        std::size_t i = bucketOf(v);
+        if (i >= b.size()) b.resize(i + 1, 0);
+        b[i] += n;
+    }
+
+public:
+    void record(std::int64_t v, std::uint64_t n = 1) {
+        if (v >= 0) add(pos, (std::uint64_t)v, n);
+        else add(neg, (std::uint64_t)(-v), n);
+        total += n;
+    }
+
+    void merge(const LogHistogram& o) {
+        if (pos.size() < o.pos.size()) pos.resize(o.pos.size(), 0);
+        if (neg.size() < o.neg.size()) neg.resize(o.neg.size(), 0);
+        for (std::size_t i = 0; i < o.pos.size(); ++i) pos[i] += o.pos[i];
+        for (std::size_t i = 0; i < o.neg.size(); ++i) neg[i] += o.neg[i];
+        total += o.total;
+    }
+
+    std::uint64_t count() const { return total; }
+
+    // Value at quantile q in [0, 1]; 0 when empty.
+    double quantile(double q) const {
+        if (!total) return 0;
+        std::uint64_t rank = (std::uint64_t)std::max(1.0, std::min((double)total, q * total + 0.5));
+        std::uint64_t seen = 0;
+        for (std::size_t i = neg.size(); i-- > 0;)
+            if ((seen += neg[i]) >= rank) return -valueOf(i);
+        for (std::size_t i = 0; i < pos.size(); ++i)
+            if ((seen += pos[i]) >= rank) return valueOf(i);
+        return 0;
+    }
+
+    void clear() { pos.clear(); neg.clear(); total = 0; }
+
+    // For checkpoint archives (checkpoint.hpp).
+    auto fields() { return std::tie(pos, neg, total); }
+};
+
+class MetricsAccumulator {
+    std::uint64_t n = 0, responded = 0;
+    std::int64_t sum_wait = 0, sum_turn = 0, sum_resp = 0, busy = 0;
+    std::int64_t max_wait = std::numeric_limits<std::int64_t>::min();
+    std::int64_t total_time = 0, capacity = 0;
+    std::int64_t lost = 0;   // CPU time spent switching rather than running
+    LogHistogram wait_h, turn_h, resp_h;
+
+public:
+    void reset() { *this = MetricsAccumulator(); }
+
+    // First time a process gets the CPU.
+    void firstDispatch(std::int64_t arrival, std::int64_t now) {
+        ++responded;
+        sum_resp += now - arrival;
+        resp_h.record(now - arrival);
+    }
+
+    void complete(std::int64_t waiting, std::int64_t turnaround, std::int64_t burst) {
+        ++n;
+        sum_wait += waiting;
+        sum_turn += turnaround;
+        busy += burst;
+        max_wait = std::max(max_wait, waiting);
+        wait_h.record(waiting);
+        turn_h.record(turnaround);
+    }
+
+    // Context-switch and cache warm-up time.
+    void overhead(std::int64_t time) { lost += time; }
+
+    // `cpus` CPUs were available for `end_time` units.
+    void finish(std::int64_t end_time, int cpus = 1) { total_time += end_time; capacity += end_time * cpus; }
+
+    // Combines runs, e.g. replications of one configuration on several threads.
+    void merge(const MetricsAccumulator& o) {
+        n += o.n; responded += o.responded;
+        sum_wait += o.sum_wait; sum_turn += o.sum_turn; sum_resp += o.sum_resp; busy += o.busy;
+        max_wait = std::max(max_wait, o.max_wait);
+        total_time += o.total_time;
+        capacity += o.capacity;
+        lost += o.lost;
+        wait_h.merge(o.wait_h); turn_h.merge(o.turn_h); resp_h.merge(o.resp_h);
+    }
+
+    std::uint64_t completed() const { return n; }
+    std::int64_t totalTime() const { return total_time; }
+    double avgWait() const { return n ? (double)sum_wait / n : 0; }
+    double avgTurnaround() const { return n ? (double)sum_turn / n : 0; }
+    double avgResponse() const { return responded ? (double)sum_resp / responded : 0; }
+    double maxWait() const { return n ? (double)max_wait : 0; }
+    double cpuUtilization() const { return capacity > 0 ? (double)busy / capacity * 100 : 0; }
+    std::int64_t overheadTime() const { return lost; }
+    double overheadShare() const { return capacity > 0 ? (double)lost / capacity * 100 : 0; }
+    double throughput() const { return total_time > 0 ? (double)n / total_time : 0; }
+    const LogHistogram& waiting() const { return wait_h; }
+    const LogHistogram& turnaround() const { return turn_h; }
+    const LogHistogram& response() const { return resp_h; }
+
+    auto fields() {
+        return std::tie(n, responded, sum_wait, sum_turn, sum_resp, busy, max_wait, total_time, capacity, lost,
+                        wait_h, turn_h, resp_h);
+    }
+};
+
+// Per-window series over simulated time, fed from the same events as the
+// accumulator. A window is a fixed span of simulated time; the CPU counts as
+// busy from a dispatch until the next dispatch or completion. Storage is one
+// record per window whatever the number of events in it.
+class WindowSeries {
+    struct Window {
+        std::int64_t busy = 0, wait_sum = 0;
+        std::uint64_t completions = 0, dispatches = 0, depth_sum = 0, max_depth = 0;
+    };
+    std::int64_t width;
+    std::vector<Window> windows;
+    std::int64_t end_time = 0, since = 0;
+    bool running = false;
+
+    Window& at(std::int64_t t) {
+        std::size_t i = t > 0 ? (std::size_t)(t / width) : 0;
+        if (i >= windows.size()) windows.resize(i + 1);
+        return windows[i];
+    }
+    // Charges [since, now) to the windows it overlaps.
+    void stop(std::int64_t now) {
+        if (!running) return;
+        running = false;
+        for (std::int64_t a = since; a < now;) {
+            std::int64_t b = std::min(now, (a / width + 1) * width);
+            at(a).busy += b - a;
+            a = b;
+        }
+    }
+
+public:
+    explicit WindowSeries(std::int64_t window) : width(window > 0 ? window : 1) {}
+
+    void reset() { windows.clear(); end_time = since = 0; running = false; }
+
+    void dispatch(std::int64_t now, std::size_t depth) {
+        stop(now);
+        running = true;
+        since = now;
+        Window& w = at(now);
+        ++w.dispatches;
+        w.depth_sum += depth;
+        w.max_depth = std::max<std::uint64_t>(w.max_depth, depth);
+    }
+
+    // A completion at a window boundary belongs to the window it ran in.
+    void complete(std::int64_t now, std::int64_t waiting) {
+        stop(now);
+        Window& w = at(now - 1);
+        ++w.completions;
+        w.wait_sum += waiting;
+    }
+
+    void finish(std::int64_t end) {
+        stop(end);
+        end_time = end;
+        if (end > 0) at(end - 1);
+    }
+
+    std::size_t size() const { return windows.size(); }
+
+    // One row per window. Utilization and throughput are over the part of
+    // the window before the end of the run; ready length is the mean and
+    // maximum seen by dispatch decisions, wait the mean over completions.
+    void writeCsv(std::ostream& out) const {
+        out << "window_start,window_end,utilization,throughput,completions,dispatches,avg_ready,max_ready,avg_wait\n";
+        for (std::size_t i = 0; i < windows.size(); ++i) {
+            const Window& w = windows[i];
+            std::int64_t start = (std::int64_t)i * width;
+            std::int64_t stop_at = std::min(start + width, std::max(end_time, start + 1));
+            double len = (double)(stop_at - start);
+            out << start << "," << stop_at << "," << w.busy / len * 100 << "," << w.completions / len << ","
+                << w.completions << "," << w.dispatches << ","
+                << (w.dispatches ? (double)w.depth_sum / w.dispatches : 0) << "," << w.max_depth << ","
+                << (w.completions ? (double)w.wait_sum / w.completions : 0) << "\n";
+        }
+    }
+};
@@ -0,0 +1,87 @@
+// predict.hpp
+// Online CPU burst prediction for SJF and SRTF. Nothing knows a burst before
+// it runs, so the policies order by an exponential average of the bursts
+// seen so far,
+//   tau' = alpha * t + (1 - alpha) * tau,
+// kept both per process (for processes with several CPU bursts, i.e. with
+// I/O) and per process class. The class is the process ID without its
+// trailing number, so "web-12" and "web7" share "web". A burst is predicted
+// from its process's own history when it has one, else from its class, else
+// from the initial estimate. Every finished burst is scored against the
+// estimate it was scheduled with.
+#pragma once
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "memory.hpp"
+
+struct PredictionStats {
+    std::uint64_t bursts = 0;
+    double abs_error = 0;     // sum of |actual - predicted|
+    double error = 0;         // sum of actual - predicted
+    double rel_error = 0;     // sum of |actual - predicted| / actual
+
+    double meanAbsError() const { return bursts ? abs_error / bursts : 0; }
+    // Positive when bursts run longer than predicted.
+    double bias() const { return bursts ? error / bursts : 0; }
+    double meanRelError() const { return bursts ? 100 * rel_error / bursts : 0; }
+};
+
+class BurstPredictor {
+    double alpha, initial;
+    std::unordered_map<std::string, int> classes;
+    ReadyVector<double> class_tau;
+    ReadyVector<int> cls;         // class of every process
+    ReadyVector<double> tau;      // per process, < 0 before its first burst
+    PredictionStats st;
+
+public:
+    BurstPredictor(double alpha_, double initial_) : alpha(alpha_), initial(initial_) {}
+
+    static std::string classOf(const std::string& id) {
+        std::size_t end = id.size();
+        while (end > 0 && std::isdigit((unsigned char)id[end - 1])) --end;
+        while (end > 0 && (id[end - 1] == '-' || id[end - 1] == '_' || id[end - 1] == '.')) --end;
+        return end > 0 ? id.substr(0, end) : id;
+    }
+
+    // Forgets all history and takes the classes of `procs`.
+    template <class ProcTable>
+    void reset(const ProcTable& procs) {
+        classes.clear();
+        class_tau.clear();
+        cls.assign(procs.size(), 0);
+        tau.assign(procs.size(), -1);
+        st = PredictionStats();
+        for (std::size_t i = 0; i < procs.size(); ++i) {
+            auto [it, added] = classes.emplace(classOf(procs[i].id), (int)class_tau.size());
+            if (added) class_tau.push_back(-1);
+            cls[i] = it->second;
+        }
+    }
+
+    // Expected length of process i's next burst.
+    double estimate(int i) const {
+        if (tau[i] >= 0) return tau[i];
+        double c = class_tau[cls[i]];
+        return c >= 0 ? c : initial;
+    }
+
+    // Process i finished a burst of `actual` units scheduled as `predicted`.
+    void observe(int i, long long actual, double predicted) {
+        double err = (double)actual - predicted;
+        ++st.bursts;
+        st.abs_error += std::fabs(err);
+        st.error += err;
+        if (actual > 0) st.rel_error += std::fabs(err) / actual;
+        tau[i] = tau[i] >= 0 ? alpha * actual + (1 - alpha) * tau[i] : alpha * actual + (1 - alpha) * estimate(i);
+        double& c = class_tau[cls[i]];
+        c = c >= 0 ? alpha * actual + (1 - alpha) * c : alpha * actual + (1 - alpha) * initial;
+    }
+
+    const PredictionStats& stats() const { return st; }
+};
@@ -0,0 +1,62 @@
+// progress.hpp
+// Periodic progress line for long simulations. The instrumented counters call
+// check() after a countdown of dispatches; check() reads the wall clock and
+// returns the next countdown, sized so that checks land a few times per
+// interval no matter how expensive a single dispatch is.
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <ostream>
+
+class Heartbeat {
+    using Clock = std::chrono::steady_clock;
+    std::ostream& out;
+    double interval;
+    std::size_t total;
+    Clock::time_point start, last_check, last_report;
+    std::uint64_t last_events = 0;
+    std::uint32_t every = 64;
+
+    void report(long long sim_time, std::size_t completed, std::uint64_t events,
+                std::size_t depth, Clock::time_point now) {
+        double elapsed = std::chrono::duration<double>(now - start).count();
+        double span = std::chrono::duration<double>(now - last_report).count();
+        double frac = total ? (double)completed / total : 0;
+        double rate = span > 0 ? (events - last_events) / span : 0;
+        char buf[192];
+        if (frac > 0)
+            std::snprintf(buf, sizeof buf, "[progress] t=%lld done=%.1f%% (%zu/%zu) events/s=%.3g ready=%zu eta=%.1fs\n",
+                          sim_time, frac * 100, completed, total, rate, depth, elapsed * (1 - frac) / frac);
+        else
+            std::snprintf(buf, sizeof buf, "[progress] t=%lld done=0.0%% (0/%zu) events/s=%.3g ready=%zu eta=?\n",
+                          sim_time, total, rate, depth);
+        out << buf << std::flush;
+        last_report = now;
+        last_events = events;
+    }
+
+public:
+    Heartbeat(std::ostream& o, double interval_sec, std::size_t total_procs)
+        : out(o), interval(interval_sec), total(total_procs),
+          start(Clock::now()), last_check(start), last_report(start) {}
+
+    std::uint32_t initialCountdown() const { return every; }
+
+    // Returns how many dispatches to wait before the next call.
+    std::uint32_t check(long long sim_time, std::size_t completed, std::uint64_t events, std::size_t depth) {
+        auto now = Clock::now();
+        double since = std::chrono::duration<double>(now - last_check).count();
+        last_check = now;
+        if (since < interval / 16 && every < (1u << 20)) every *= 2;
+        else if (since > interval / 4 && every > 1) every /= 2;
+        if (std::chrono::duration<double>(now - last_report).count() >= interval)
+            report(sim_time, completed, events, depth, now);
+        return every;
+    }
+
+    void finish(long long sim_time, std::size_t completed, std::uint64_t events) {
+        report(sim_time, completed, events, 0, Clock::now());
+    }
+};
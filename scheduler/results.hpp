@@ -0,0 +1,380 @@
+// results.hpp
+// Result writers for the per-process table, the Gantt segments and the run
+// aggregates. Output is formatted with std::to_chars into a large buffer that
+// goes to the underlying stream in big writes, so printing millions of
+// segments costs about as much as copying them.
+//
+// Binary layout (--format bin), native byte order:
+//   ResultBinHeader
+//   ResultBinSummary
+//   id_count ids: uint32 length, then the bytes
+//   proc_count ResultBinProcess
+//   segment_count ResultBinSegment
+// Process and segment ids index the id table; idle time uses the id "IDLE".
+#pragma once
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "metrics.hpp"
+
+enum class ResultFormat { Text, Csv, Json, Bin };
+
+inline bool parseResultFormat(const std::string& name, ResultFormat& fmt) {
+    if (name.empty() || name == "text") fmt = ResultFormat::Text;
+    else if (name == "csv") fmt = ResultFormat::Csv;
+    else if (name == "json") fmt = ResultFormat::Json;
+    else if (name == "bin") fmt = ResultFormat::Bin;
+    else return false;
+    return true;
+}
+
+// Append-only buffer in front of an ostream; flushed when full and on
+// destruction.
+class OutBuffer {
+    static constexpr std::size_t kSize = 1 << 20;
+    std::ostream& out;
+    std::vector<char> buf;
+    std::size_t n = 0;
+
+    char* reserve(std::size_t len) {
+        if (n + len > buf.size()) {
+            flush();
+            if (len > buf.size()) buf.resize(len);
+        }
+        return buf.data() + n;
+    }
+
+public:
+    explicit OutBuffer(std::ostream& o) : out(o), buf(kSize) {}
+    ~OutBuffer() { flush(); }
+    OutBuffer(const OutBuffer&) = delete;
+    OutBuffer& operator=(const OutBuffer&) = delete;
+
+    void flush() {
+        if (n) out.write(buf.data(), (std::streamsize)n);
+        n = 0;
+    }
+    OutBuffer& put(std::string_view s) {
+        std::memcpy(reserve(s.size()), s.data(), s.size());
+        n += s.size();
+        return *this;
+    }
+    OutBuffer& put(char c) {
+        *reserve(1) = c;
+        ++n;
+        return *this;
+    }
+    OutBuffer& num(long long v) {
+        char* p = reserve(24);
+        n = std::to_chars(p, p + 24, v).ptr - buf.data();
+        return *this;
+    }
+    // Shortest text that reads back as `v`.
+    OutBuffer& num(double v) {
+        char* p = reserve(32);
+        n = std::to_chars(p, p + 32, v).ptr - buf.data();
+        return *this;
+    }
+    // Six significant digits, as ostream's default formatting prints.
+    OutBuffer& num6(double v) {
+        char* p = reserve(32);
+        n = std::to_chars(p, p + 32, v, std::chars_format::general, 6).ptr - buf.data();
+        return *this;
+    }
+    OutBuffer& raw(const void* data, std::size_t len) {
+        std::memcpy(reserve(len), data, len);
+        n += len;
+        return *this;
+    }
+    template <class T> OutBuffer& raw(const T& v) { return raw(&v, sizeof v); }
+};
+
+struct ResultBinHeader {
+    char magic[8];                // "SIMRES\0\0"
+    std::uint32_t version;
+    std::uint32_t id_count;
+    std::uint64_t proc_count;
+    std::uint64_t segment_count;
+};
+
+struct ResultBinSummary {
+    std::int64_t total_time;
+    std::uint64_t completed;
+    double avg_wait, avg_turnaround, avg_response, max_wait, cpu_util, throughput;
+    double p50_wait, p95_wait, p99_wait, p95_response, p99_response, p95_turnaround, p99_turnaround;
+};
+
+// Times are 64-bit whatever SimTime is, so files read back in any build.
+struct ResultBinProcess {
+    std::uint32_t id;
+    std::int32_t priority;
+    std::int64_t arrival, burst, deadline, start, waiting, turnaround;
+};
+
+struct ResultBinSegment {
+    std::uint32_t id;
+    std::int64_t duration;
+    std::int64_t start;
+};
+
+namespace results_detail {
+
+// Ids come from workload files; quote what would break the format.
+inline void jsonString(OutBuffer& b, std::string_view s) {
+    b.put('"');
+    for (char c : s) {
+        if (c == '"' || c == '\\') b.put('\\').put(c);
+        else if ((unsigned char)c < 0x20) b.put(' ');
+        else b.put(c);
+    }
+    b.put('"');
+}
+
+inline void csvField(OutBuffer& b, std::string_view s) {
+    if (s.find_first_of(",\"\n") == std::string_view::npos) { b.put(s); return; }
+    b.put('"');
+    for (char c : s) { if (c == '"') b.put('"'); b.put(c); }
+    b.put('"');
+}
+
+struct Aggregate { const char* name; double value; };
+
+inline std::vector<Aggregate> aggregates(const MetricsAccumulator& m) {
+    return {
+        {"total_time", (double)m.totalTime()},
+        {"completed", (double)m.completed()},
+        {"avg_wait", m.avgWait()},
+        {"avg_turnaround", m.avgTurnaround()},
+        {"avg_response", m.avgResponse()},
+        {"max_wait", m.maxWait()},
+        {"cpu_util", m.cpuUtilization()},
+        {"switch_overhead", (double)m.overheadTime()},
+        {"throughput", m.throughput()},
+        {"p50_wait", m.waiting().quantile(0.50)},
+        {"p95_wait", m.waiting().quantile(0.95)},
+        {"p99_wait", m.waiting().quantile(0.99)},
+        {"p95_response", m.response().quantile(0.95)},
+        {"p99_response", m.response().quantile(0.99)},
+        {"p95_turnaround", m.turnaround().quantile(0.95)},
+        {"p99_turnaround", m.turnaround().quantile(0.99)},
+    };
+}
+
+template <class ProcTable, class Chart>
+void writeText(OutBuffer& b, const ProcTable& procs, const Chart& gantt, const MetricsAccumulator& m,
+               bool full_gantt) {
+    if (full_gantt) {
+        b.put("Gantt Chart: ");
+        for (const auto& e : gantt) b.put(e.first).put('(').num((long long)e.second).put(") ");
+        b.put('\n');
+    }
+    b.put("Average Waiting Time: ").num6(m.avgWait())
+     .put("\nAverage Turnaround Time: ").num6(m.avgTurnaround())
+     .put("\nCPU Utilization: ").num6(m.cpuUtilization()).put('%');
+    if (m.overheadTime() > 0)
+        b.put("\nSwitch Overhead: ").num((long long)m.overheadTime()).put(" (").num6(m.overheadShare())
+         .put("% of CPU time lost)");
+    b.put("\nThroughput: ").num6(m.throughput())
+     .put(" processes/unit time\nWaiting Time p50/p95/p99/max: ").num6(m.waiting().quantile(0.50))
+     .put(" / ").num6(m.waiting().quantile(0.95)).put(" / ").num6(m.waiting().quantile(0.99))
+     .put(" / ").num6(m.maxWait())
+     .put("\nResponse Time avg/p50/p95/p99: ").num6(m.avgResponse())
+     .put(" / ").num6(m.response().quantile(0.50)).put(" / ").num6(m.response().quantile(0.95))
+     .put(" / ").num6(m.response().quantile(0.99))
+     .put("\nTurnaround Time p95/p99: ").num6(m.turnaround().quantile(0.95))
+     .put(" / ").num6(m.turnaround().quantile(0.99))
+     .put("\nProcess\tArrival\tBurst\tPriority\tStart\tWaiting\tTurnaround\n");
+    for (const auto& p : procs)
+        b.put(p.id).put('\t').num((long long)p.arrival_time).put('\t').num((long long)p.burst_time)
+         .put('\t').num((long long)p.priority).put('\t').num((long long)p.start_time)
+         .put('\t').num((long long)p.waiting_time).put('\t').num((long long)p.turnaround_time).put('\n');
+}
+
+// Three sections, each with its own header row, separated by blank lines.
+template <class ProcTable, class Chart>
+void writeCsv(OutBuffer& b, const ProcTable& procs, const Chart& gantt, const MetricsAccumulator& m) {
+    b.put("id,arrival,burst,priority,deadline,start,waiting,turnaround\n");
+    for (const auto& p : procs) {
+        csvField(b, p.id);
+        b.put(',').num((long long)p.arrival_time).put(',').num((long long)p.burst_time)
+         .put(',').num((long long)p.priority).put(',').num((long long)p.deadline)
+         .put(',').num((long long)p.start_time).put(',').num((long long)p.waiting_time)
+         .put(',').num((long long)p.turnaround_time).put('\n');
+    }
+    b.put("\nsegment,start,duration\n");
+    long long t = 0;
+    for (const auto& e : gantt) {
+        csvField(b, e.first);
+        b.put(',').num(t).put(',').num((long long)e.second).put('\n');
+        t += e.second;
+    }
+    b.put("\nmetric,value\n");
+    for (const auto& a : aggregates(m)) b.put(a.name).put(',').num(a.value).put('\n');
+}
+
+template <class ProcTable, class Chart>
+void writeJson(OutBuffer& b, const ProcTable& procs, const Chart& gantt, const MetricsAccumulator& m) {
+    b.put("{\"processes\": [");
+    bool first = true;
+    for (const auto& p : procs) {
+        b.put(first ? "\n  {\"id\": " : ",\n  {\"id\": ");
+        jsonString(b, p.id);
+        b.put(", \"arrival\": ").num((long long)p.arrival_time)
+         .put(", \"burst\": ").num((long long)p.burst_time)
+         .put(", \"priority\": ").num((long long)p.priority)
+         .put(", \"deadline\": ").num((long long)p.deadline)
+         .put(", \"start\": ").num((long long)p.start_time)
+         .put(", \"waiting\": ").num((long long)p.waiting_time)
+         .put(", \"turnaround\": ").num((long long)p.turnaround_time).put('}');
+        first = false;
+    }
+    b.put("\n], \"gantt\": [");
+    first = true;
+    long long t = 0;
+    for (const auto& e : gantt) {
+        b.put(first ? "\n  {\"id\": " : ",\n  {\"id\": ");
+        jsonString(b, e.first);
+        b.put(", \"start\": ").num(t).put(", \"duration\": ").num((long long)e.second).put('}');
+        t += e.second;
+        first = false;
+    }
+    b.put("\n], \"summary\": {");
+    first = true;
+    for (const auto& a : aggregates(m)) {
+        b.put(first ? "\"" : ", \"").put(a.name).put("\": ");
+        if (std::isfinite(a.value)) b.num(a.value);
+        else b.put("null");
+        first = false;
+    }
+    b.put("}}\n");
+}
+
+template <class ProcTable, class Chart>
+void writeBin(OutBuffer& b, const ProcTable& procs, const Chart& gantt, const MetricsAccumulator& m) {
+    // Process ids first, in table order, then ids only seen in the chart.
+    std::vector<std::string_view> ids;
+    std::unordered_map<std::string_view, std::uint32_t> index;
+    auto idOf = [&](std::string_view id) {
+        auto it = index.emplace(id, (std::uint32_t)ids.size());
+        if (it.second) ids.push_back(id);
+        return it.first->second;
+    };
+    for (const auto& p : procs) idOf(p.id);
+    std::vector<std::uint32_t> seg_ids;
+    seg_ids.reserve(gantt.size());
+    for (const auto& e : gantt) seg_ids.push_back(idOf(e.first));
+
+    ResultBinHeader hdr{};
+    std::memcpy(hdr.magic, "SIMRES\0\0", 8);
+    hdr.version = 2;
+    hdr.id_count = (std::uint32_t)ids.size();
+    hdr.proc_count = procs.size();
+    hdr.segment_count = gantt.size();
+    b.raw(hdr);
+
+    ResultBinSummary sum{};
+    sum.total_time = m.totalTime();
+    sum.completed = m.completed();
+    sum.avg_wait = m.avgWait();
+    sum.avg_turnaround = m.avgTurnaround();
+    sum.avg_response = m.avgResponse();
+    sum.max_wait = m.maxWait();
+    sum.cpu_util = m.cpuUtilization();
+    sum.throughput = m.throughput();
+    sum.p50_wait = m.waiting().quantile(0.50);
+    sum.p95_wait = m.waiting().quantile(0.95);
+    sum.p99_wait = m.waiting().quantile(0.99);
+    sum.p95_response = m.response().quantile(0.95);
+    sum.p99_response = m.response().quantile(0.99);
+    sum.p95_turnaround = m.turnaround().quantile(0.95);
+    sum.p99_turnaround = m.turnaround().quantile(0.99);
+    b.raw(sum);
+
+    for (std::string_view id : ids) {
+        std::uint32_t len = (std::uint32_t)id.size();
+        b.raw(len).raw(id.data(), len);
+    }
+    for (std::size_t i = 0; i < procs.size(); ++i) {
+        const auto& p = procs[i];
+        b.raw(ResultBinProcess{(std::uint32_t)i, p.priority, p.arrival_time, p.burst_time, p.deadline,
+                               p.start_time, p.waiting_time, p.turnaround_time});
+    }
+    std::int64_t t = 0;
+    for (std::size_t i = 0; i < gantt.size(); ++i) {
+        b.raw(ResultBinSegment{seg_ids[i], gantt[i].second, t});
+        t += gantt[i].second;
+    }
+}
+
+} // namespace results_detail
+
+// Writes the run's results to `out` in `fmt`. Text keeps the report the
+// simulator has always printed and adds the per-process table after it;
+// `full_gantt` false leaves out its one-line Gantt chart, for callers that
+// render a downsampled view instead.
+template <class ProcTable, class Chart>
+void writeResults(std::ostream& out, ResultFormat fmt, const ProcTable& procs, const Chart& gantt,
+                  const MetricsAccumulator& m, bool full_gantt = true) {
+    OutBuffer b(out);
+    switch (fmt) {
+        case ResultFormat::Text: results_detail::writeText(b, procs, gantt, m, full_gantt); break;
+        case ResultFormat::Csv:  results_detail::writeCsv(b, procs, gantt, m); break;
+        case ResultFormat::Json: results_detail::writeJson(b, procs, gantt, m); break;
+        case ResultFormat::Bin:  results_detail::writeBin(b, procs, gantt, m); break;
+    }
+    b.flush();
+    out.flush();
+}
+
+// A --format bin file read back, for tools that work on a finished schedule.
+struct LoadedResults {
+    ResultBinSummary summary{};
+    std::vector<std::string> ids;
+    std::vector<ResultBinProcess> procs;
+    std::vector<ResultBinSegment> segments;
+};
+
+inline bool readResultsBin(const std::string& path, LoadedResults& r) {
+    std::FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f) return false;
+    // Counts come from the file; each is checked against the bytes still
+    // unread before anything is allocated for it.
+    long size = std::fseek(f, 0, SEEK_END) == 0 ? std::ftell(f) : -1;
+    std::uint64_t left = size > 0 ? (std::uint64_t)size : 0;
+    ResultBinHeader hdr;
+    bool ok = size >= 0 && std::fseek(f, 0, SEEK_SET) == 0 && std::fread(&hdr, sizeof hdr, 1, f) == 1 &&
+              std::memcmp(hdr.magic, "SIMRES\0\0", 8) == 0 && hdr.version == 2 &&
+              std::fread(&r.summary, sizeof r.summary, 1, f) == 1;
+    if (ok) left -= std::min<std::uint64_t>(left, sizeof hdr + sizeof r.summary);
+    r.ids.clear();
+    ok = ok && (std::uint64_t)hdr.id_count * sizeof(std::uint32_t) <= left;
+    for (std::uint32_t i = 0; ok && i < hdr.id_count; ++i) {
+        std::uint32_t len;
+        ok = std::fread(&len, sizeof len, 1, f) == 1 && (left -= sizeof len, len <= left);
+        if (!ok) break;
+        std::string id(len, '\0');
+        ok = std::fread(id.data(), 1, len, f) == len;
+        left -= len;
+        r.ids.push_back(std::move(id));
+    }
+    ok = ok && hdr.proc_count <= left / sizeof(ResultBinProcess) &&
+         hdr.segment_count <= (left - hdr.proc_count * sizeof(ResultBinProcess)) / sizeof(ResultBinSegment);
+    if (ok) {
+        r.procs.resize(hdr.proc_count);
+        r.segments.resize(hdr.segment_count);
+        ok = std::fread(r.procs.data(), sizeof(ResultBinProcess), r.procs.size(), f) == r.procs.size() &&
+             std::fread(r.segments.data(), sizeof(ResultBinSegment), r.segments.size(), f) == r.segments.size();
+        for (const auto& sg : r.segments) ok = ok && sg.id < r.ids.size();
+    }
+    std::fclose(f);
+    return ok;
+}
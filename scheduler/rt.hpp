@@ -0,0 +1,245 @@
+// rt.hpp
+// Periodic real-time tasks. A task releases a job every PERIOD time units
+// from its OFFSET on; each job needs WCET units of CPU and is due DEADLINE
+// units after its release (the period when not given). Task set files have
+// one task per line, '#' starting a comment:
+//   task ID PERIOD WCET [DEADLINE [OFFSET]]
+//
+// Jobs exist only while they are pending: a heap holds each task's next
+// release time, and a job is created when simulated time reaches it, so a
+// long horizon costs time but no memory. The CPU goes to the pending job
+// with the earliest absolute deadline (EDF), the shortest period (rate
+// monotonic) or the shortest relative deadline (deadline monotonic), and a
+// release preempts the running job when it has higher priority. Late jobs
+// keep running to completion and count as misses, as do jobs still pending
+// past their deadline at the end of the horizon.
+#pragma once
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <numeric>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+#include "memory.hpp"
+#include "results.hpp"
+
+struct PeriodicTask {
+    std::string id;
+    long long period = 0;
+    long long wcet = 0;
+    long long deadline = 0;   // relative to the release
+    long long offset = 0;     // first release
+};
+
+enum class RtPolicy { Edf, Rm, Dm };
+
+inline bool parseRtPolicy(const std::string& name, RtPolicy& policy) {
+    if (name == "edf") policy = RtPolicy::Edf;
+    else if (name == "rm") policy = RtPolicy::Rm;
+    else if (name == "dm") policy = RtPolicy::Dm;
+    else return false;
+    return true;
+}
+
+// Reads a task set; false with `error` set on a malformed line.
+inline bool loadTaskSet(const std::string& filename, std::vector<PeriodicTask>& tasks, std::string& error) {
+    std::ifstream in(filename);
+    if (!in) { error = "Could not open task set: " + filename; return false; }
+    std::string line;
+    for (int n = 1; std::getline(in, line); ++n) {
+        std::istringstream ss(line);
+        std::string word;
+        if (!(ss >> word) || word[0] == '#') continue;
+        PeriodicTask t;
+        if (word != "task" || !(ss >> t.id >> t.period >> t.wcet) || t.period < 1 || t.wcet < 1) {
+            error = "Bad task at line " + std::to_string(n) + ": " + line;
+            return false;
+        }
+        if (!(ss >> t.deadline)) t.deadline = t.period;
+        else if (!(ss >> t.offset)) t.offset = 0;
+        if (t.deadline < 1 || t.offset < 0) {
+            error = "Bad task at line " + std::to_string(n) + ": " + line;
+            return false;
+        }
+        tasks.push_back(t);
+    }
+    if (tasks.empty()) { error = "No tasks in " + filename; return false; }
+    return true;
+}
+
+// Least common multiple of the periods, or LLONG_MAX when it overflows.
+inline long long hyperperiod(const std::vector<PeriodicTask>& tasks) {
+    long long h = 1;
+    for (const auto& t : tasks) {
+        long long g = std::gcd(h, t.period);
+        if (h / g > LLONG_MAX / t.period) return LLONG_MAX;
+        h = h / g * t.period;
+    }
+    return h;
+}
+
+inline double utilization(const std::vector<PeriodicTask>& tasks) {
+    double u = 0;
+    for (const auto& t : tasks) u += (double)t.wcet / t.period;
+    return u;
+}
+
+// Long enough to repeat the schedule of a feasible set: one hyperperiod
+// when all tasks start together, the last offset plus two otherwise. Capped
+// at 1000 of the longest period.
+inline long long defaultHorizon(const std::vector<PeriodicTask>& tasks) {
+    long long first = tasks[0].offset, last = 0, longest = 0;
+    for (const auto& t : tasks) {
+        first = std::min(first, t.offset);
+        last = std::max(last, t.offset);
+        longest = std::max(longest, t.period);
+    }
+    long long cap = longest > LLONG_MAX / 1000 ? LLONG_MAX / 4 : longest * 1000;
+    long long span = std::min(hyperperiod(tasks), cap);
+    return first == last ? last + span : last + 2 * span;
+}
+
+struct RtTaskStats {
+    std::uint64_t released = 0, completed = 0, missed = 0;
+    long long min_response = LLONG_MAX, max_response = 0;
+    double sum_response = 0, sum_sq_response = 0;
+    long long max_lateness = 0;
+
+    double avgResponse() const { return completed ? sum_response / completed : 0; }
+    // Spread of response times between jobs: max - min, and standard deviation.
+    long long jitter() const { return completed ? max_response - min_response : 0; }
+    double responseStddev() const {
+        if (!completed) return 0;
+        double mean = avgResponse();
+        return std::sqrt(std::max(0.0, sum_sq_response / completed - mean * mean));
+    }
+};
+
+struct RtRun {
+    long long horizon = 0;
+    long long busy = 0;
+    std::uint64_t preemptions = 0, switches = 0;
+    std::vector<RtTaskStats> tasks;
+};
+
+// Runs the task set on one CPU until `horizon`. `segment`, when given,
+// receives every stretch of execution as (task, start, duration).
+inline RtRun simulatePeriodic(const std::vector<PeriodicTask>& tasks, RtPolicy policy, long long horizon,
+                              const std::function<void(int, long long, long long)>& segment = {}) {
+    struct Job {
+        long long key;        // priority, lower runs first
+        long long release;
+        int task;
+        long long deadline;   // absolute
+        long long left;
+        bool operator>(const Job& o) const {
+            return std::tie(key, release, task) > std::tie(o.key, o.release, o.task);
+        }
+    };
+    using Release = std::pair<long long, int>;
+    ReadyHeap<Release, std::greater<Release>> releases;
+    ReadyHeap<Job, std::greater<Job>> ready;
+    RtRun run;
+    run.horizon = horizon;
+    run.tasks.resize(tasks.size());
+    for (std::size_t i = 0; i < tasks.size(); ++i)
+        if (tasks[i].offset < horizon) releases.push({tasks[i].offset, (int)i});
+
+    auto keyOf = [&](int i, long long release) {
+        const PeriodicTask& t = tasks[i];
+        switch (policy) {
+            case RtPolicy::Edf: return release + t.deadline;
+            case RtPolicy::Rm:  return t.period;
+            case RtPolicy::Dm:  return t.deadline;
+        }
+        return 0LL;
+    };
+
+    Job cur{};
+    bool running = false;
+    int last = -1;
+    long long t = 0;
+    while (t < horizon) {
+        while (!releases.empty() && releases.top().first <= t) {
+            auto [at, i] = releases.top();
+            releases.pop();
+            ready.push({keyOf(i, at), at, i, at + tasks[i].deadline, tasks[i].wcet});
+            ++run.tasks[i].released;
+            if (at < horizon - tasks[i].period) releases.push({at + tasks[i].period, i});
+        }
+        if (running && !ready.empty() && ready.top().key < cur.key) {
+            ready.push(cur);
+            running = false;
+            ++run.preemptions;
+        }
+        if (!running && !ready.empty()) {
+            cur = ready.top();
+            ready.pop();
+            running = true;
+            if (cur.task != last) ++run.switches;
+            last = cur.task;
+        }
+        long long next = releases.empty() ? horizon : std::min(horizon, releases.top().first);
+        if (running) {
+            next = std::min(next, t + cur.left);
+            cur.left -= next - t;
+            run.busy += next - t;
+            if (segment) segment(cur.task, t, next - t);
+        }
+        t = next;
+        if (running && cur.left == 0) {
+            RtTaskStats& s = run.tasks[cur.task];
+            long long response = t - cur.release;
+            ++s.completed;
+            s.min_response = std::min(s.min_response, response);
+            s.max_response = std::max(s.max_response, response);
+            s.sum_response += response;
+            s.sum_sq_response += (double)response * response;
+            if (t > cur.deadline) {
+                ++s.missed;
+                s.max_lateness = std::max(s.max_lateness, t - cur.deadline);
+            }
+            running = false;
+        }
+    }
+    // Unfinished jobs already past their deadline missed it too.
+    if (running) ready.push(cur);
+    for (; !ready.empty(); ready.pop()) {
+        const Job& j = ready.top();
+        if (j.deadline <= horizon) {
+            RtTaskStats& s = run.tasks[j.task];
+            ++s.missed;
+            s.max_lateness = std::max(s.max_lateness, horizon - j.deadline);
+        }
+    }
+    return run;
+}
+
+inline void printRtReport(std::ostream& out, const std::vector<PeriodicTask>& tasks, const RtRun& run) {
+    std::uint64_t jobs = 0, missed = 0;
+    for (const auto& s : run.tasks) { jobs += s.released; missed += s.missed; }
+    OutBuffer b(out);
+    b.put("Horizon: ").num(run.horizon).put(", utilization ").num6(utilization(tasks))
+     .put(", CPU busy ").num6(run.horizon > 0 ? 100.0 * run.busy / run.horizon : 0)
+     .put("%\nJobs: ").num((long long)jobs).put(", deadline misses ").num((long long)missed)
+     .put(", preemptions ").num((long long)run.preemptions).put(", context switches ")
+     .num((long long)run.switches).put('\n');
+    for (std::size_t i = 0; i < tasks.size(); ++i) {
+        const PeriodicTask& t = tasks[i];
+        const RtTaskStats& s = run.tasks[i];
+        b.put("Task ").put(t.id).put(": period ").num(t.period).put(", wcet ").num(t.wcet)
+         .put(", deadline ").num(t.deadline).put(", jobs ").num((long long)s.released)
+         .put(", completed ").num((long long)s.completed).put(", missed ").num((long long)s.missed)
+         .put(", response min/avg/max ").num(s.completed ? s.min_response : 0LL).put('/')
+         .num6(s.avgResponse()).put('/').num(s.max_response).put(", jitter ").num(s.jitter())
+         .put(" (sd ").num6(s.responseStddev()).put("), max lateness ").num(s.max_lateness).put('\n');
+    }
+}
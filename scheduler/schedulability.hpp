@@ -0,0 +1,279 @@
+// schedulability.hpp
+// Analytic feasibility tests for periodic task sets (rt.hpp), cheap enough
+// to screen many candidate sets before simulating any of them. Each test
+// answers feasible, infeasible or inconclusive:
+//   EDF: utilization (exact when no deadline is shorter than its period,
+//        density as a sufficient test otherwise) and the processor demand
+//        test, which checks dbf(t) <= t at every absolute deadline in the
+//        synchronous busy period.
+//   RM/DM: the Liu-Layland bound n(2^(1/n) - 1), sufficient only, and
+//        response-time analysis, iterating R = C + sum ceil(R/Tj) Cj over the
+//        higher-priority tasks, for every job of the level-i busy period so
+//        deadlines past the period are handled too.
+// The demand and response-time tests assume every task releases its first
+// job at the same time, the worst case; with differing offsets a pass is
+// still a proof, a failure is not. Tasks sharing a priority are counted as
+// interfering with each other, so a failure among them is inconclusive too.
+// Searches that would pass kMaxCheckpoints deadlines or kMaxIterations steps
+// give up as inconclusive rather than run unbounded.
+#pragma once
+#include <algorithm>
+#include <charconv>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <numeric>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "memory.hpp"
+#include "results.hpp"
+#include "rt.hpp"
+
+enum class Verdict { Feasible, Infeasible, Inconclusive };
+
+inline const char* verdictName(Verdict v) {
+    switch (v) {
+        case Verdict::Feasible:   return "feasible";
+        case Verdict::Infeasible: return "infeasible";
+        default:                  return "inconclusive";
+    }
+}
+
+struct RtTest {
+    const char* name;
+    Verdict verdict;
+    std::string detail;
+};
+
+struct RtAnalysis {
+    std::vector<RtTest> tests;
+    Verdict verdict = Verdict::Inconclusive;
+    const char* decided_by = "";   // first conclusive test, "" when none
+};
+
+namespace rt_detail {
+
+constexpr std::uint64_t kMaxCheckpoints = 10'000'000;
+constexpr int kMaxIterations = 1'000'000;
+
+inline bool synchronous(const std::vector<PeriodicTask>& tasks) {
+    for (const auto& t : tasks)
+        if (t.offset != tasks[0].offset) return false;
+    return true;
+}
+
+// Six significant digits, like the reports.
+inline std::string num6(double v) {
+    char buf[32];
+    return std::string(buf, std::to_chars(buf, buf + sizeof buf, v, std::chars_format::general, 6).ptr);
+}
+
+inline long long ceilDiv(long long a, long long b) { return a <= 0 ? 0 : (a - 1) / b + 1; }
+
+// a + b * c, false on overflow.
+inline bool addProduct(long long& a, long long b, long long c) {
+    long long p;
+    return !__builtin_mul_overflow(b, c, &p) && !__builtin_add_overflow(a, p, &a);
+}
+
+// Sign of utilization - 1, in exact fractions while they fit.
+inline int compareUtilization(const std::vector<PeriodicTask>& tasks) {
+    long long num = 0, den = 1;
+    for (const auto& t : tasks) {
+        long long g = std::gcd(den, t.period), l, a, b;
+        if (__builtin_mul_overflow(den / g, t.period, &l) || __builtin_mul_overflow(num, l / den, &a) ||
+            __builtin_mul_overflow(t.wcet, l / t.period, &b) || __builtin_add_overflow(a, b, &num)) {
+            long double u = 0;
+            for (const auto& x : tasks) u += (long double)x.wcet / x.period;
+            return u > 1 ? 1 : u < 1 ? -1 : 0;
+        }
+        den = l;
+        g = std::gcd(num, den);
+        num /= g; den /= g;
+        if (num > den) return 1;   // utilization only grows
+    }
+    return num < den ? -1 : num == den ? 0 : 1;
+}
+
+// Synchronous busy period: the first time all work released from 0 on is
+// done. -1 when it does not settle within the limits.
+inline long long busyPeriod(const std::vector<PeriodicTask>& tasks) {
+    long long w = 0;
+    for (const auto& t : tasks)
+        if (__builtin_add_overflow(w, t.wcet, &w)) return -1;
+    for (int it = 0; it < kMaxIterations; ++it) {
+        long long next = 0;
+        for (const auto& t : tasks)
+            if (!addProduct(next, ceilDiv(w, t.period), t.wcet)) return -1;
+        if (next == w) return w;
+        w = next;
+    }
+    return -1;
+}
+
+inline long long priorityKey(const PeriodicTask& t, RtPolicy policy) {
+    return policy == RtPolicy::Rm ? t.period : t.deadline;
+}
+
+inline RtTest edfUtilization(const std::vector<PeriodicTask>& tasks) {
+    RtTest r{"Utilization", Verdict::Inconclusive, ""};
+    int cmp = compareUtilization(tasks);
+    double density = 0;
+    bool implicit = true;
+    for (const auto& t : tasks) {
+        density += (double)t.wcet / std::min(t.deadline, t.period);
+        implicit = implicit && t.deadline >= t.period;
+    }
+    if (cmp > 0) { r.verdict = Verdict::Infeasible; r.detail = "U > 1"; }
+    else if (implicit) { r.verdict = Verdict::Feasible; r.detail = "U <= 1, deadlines no shorter than periods"; }
+    else if (density <= 1) { r.verdict = Verdict::Feasible; r.detail = "density <= 1"; }
+    else r.detail = "U <= 1 but deadlines shorter than periods";
+    return r;
+}
+
+inline RtTest edfDemand(const std::vector<PeriodicTask>& tasks) {
+    RtTest r{"Processor demand", Verdict::Inconclusive, ""};
+    if (compareUtilization(tasks) > 0) { r.verdict = Verdict::Infeasible; r.detail = "U > 1"; return r; }
+    long long limit = busyPeriod(tasks);
+    double u = utilization(tasks);
+    if (u < 1) {
+        // Deadlines past max(Dmax, sum (Ti - Di) Ui / (1 - U)) need no check.
+        double la = 0;
+        long long dmax = 0;
+        for (const auto& t : tasks) {
+            la += (double)(t.period - t.deadline) * t.wcet / t.period;
+            dmax = std::max(dmax, t.deadline);
+        }
+        la = std::max((double)dmax, la / (1 - u));
+        if (la < (double)LLONG_MAX / 2 && (limit < 0 || (long long)std::ceil(la) < limit))
+            limit = (long long)std::ceil(la);
+    }
+    if (limit < 0) { r.detail = "busy period too long to check"; return r; }
+
+    using Deadline = std::pair<long long, int>;
+    ReadyHeap<Deadline, std::greater<Deadline>> next;
+    for (std::size_t i = 0; i < tasks.size(); ++i)
+        if (tasks[i].deadline <= limit) next.push({tasks[i].deadline, (int)i});
+    long long demand = 0;
+    std::uint64_t checked = 0;
+    while (!next.empty()) {
+        long long d = next.top().first;
+        for (; !next.empty() && next.top().first == d; next.pop()) {
+            int i = next.top().second;
+            demand += tasks[i].wcet;
+            if (d <= limit - tasks[i].period) next.push({d + tasks[i].period, i});
+        }
+        if (++checked > kMaxCheckpoints) { r.detail = "too many deadlines to check"; return r; }
+        if (demand > d) {
+            r.detail = "dbf(" + std::to_string(d) + ") = " + std::to_string(demand) + " > " + std::to_string(d);
+            if (synchronous(tasks)) r.verdict = Verdict::Infeasible;
+            else r.detail += " for synchronous release";
+            return r;
+        }
+    }
+    r.verdict = Verdict::Feasible;
+    r.detail = std::to_string(checked) + " deadlines checked up to " + std::to_string(limit);
+    return r;
+}
+
+inline RtTest liuLayland(const std::vector<PeriodicTask>& tasks, RtPolicy policy) {
+    RtTest r{"Liu-Layland bound", Verdict::Inconclusive, ""};
+    if (compareUtilization(tasks) > 0) { r.verdict = Verdict::Infeasible; r.detail = "U > 1"; return r; }
+    // RM needs deadlines no shorter than the periods; DM, deadlines no
+    // longer, with density in place of utilization.
+    double load = 0;
+    for (const auto& t : tasks) {
+        if (policy == RtPolicy::Rm ? t.deadline < t.period : t.deadline > t.period) {
+            r.detail = policy == RtPolicy::Rm ? "deadlines shorter than periods" : "deadlines longer than periods";
+            return r;
+        }
+        load += (double)t.wcet / std::min(t.deadline, t.period);
+    }
+    double n = (double)tasks.size();
+    double bound = n * (std::pow(2.0, 1 / n) - 1);
+    r.detail = std::string(policy == RtPolicy::Rm ? "U " : "density ") + num6(load) +
+               (load <= bound ? " <= " : " > ") + "bound " + num6(bound);
+    if (load <= bound) r.verdict = Verdict::Feasible;
+    return r;
+}
+
+inline RtTest responseTime(const std::vector<PeriodicTask>& tasks, RtPolicy policy) {
+    RtTest r{"Response-time analysis", Verdict::Inconclusive, ""};
+    if (compareUtilization(tasks) > 0) { r.verdict = Verdict::Infeasible; r.detail = "U > 1"; return r; }
+    bool exact = synchronous(tasks);
+    double worst = 0;
+    std::size_t worst_task = 0;
+    for (std::size_t i = 0; i < tasks.size(); ++i) {
+        const PeriodicTask& ti = tasks[i];
+        long long key = priorityKey(ti, policy);
+        std::vector<const PeriodicTask*> hp;
+        bool ties = false;
+        for (std::size_t j = 0; j < tasks.size(); ++j) {
+            if (j == i || priorityKey(tasks[j], policy) > key) continue;
+            ties = ties || priorityKey(tasks[j], policy) == key;
+            hp.push_back(&tasks[j]);
+        }
+        // Job q of the level-i busy period finishes at the fixed point of
+        // w = (q + 1) Ci + sum ceil(w / Tj) Cj.
+        long long response = 0;
+        int steps = 0;
+        for (long long q = 0;; ++q) {
+            long long w = 0, own = 0;
+            if (!addProduct(own, q + 1, ti.wcet)) { r.detail = ti.id + ": busy period too long"; return r; }
+            for (long long next = own;; ) {
+                w = next;
+                next = own;
+                for (const PeriodicTask* t : hp)
+                    if (!addProduct(next, ceilDiv(w, t->period), t->wcet)) {
+                        r.detail = ti.id + ": busy period too long";
+                        return r;
+                    }
+                if (++steps > kMaxIterations) { r.detail = ti.id + ": too many iterations"; return r; }
+                if (next == w) break;
+                if (next - q * ti.period > ti.deadline) { w = next; break; }
+            }
+            response = std::max(response, w - q * ti.period);
+            if (response > ti.deadline) {
+                r.detail = ti.id + ": response " + std::to_string(response) + " > deadline " + std::to_string(ti.deadline);
+                if (exact && !ties) r.verdict = Verdict::Infeasible;
+                else r.detail += exact ? " counting equal priorities as higher" : " for synchronous release";
+                return r;
+            }
+            if (w <= (q + 1) * ti.period) break;   // busy period over
+        }
+        double ratio = (double)response / ti.deadline;
+        if (ratio > worst) { worst = ratio; worst_task = i; }
+    }
+    r.verdict = Verdict::Feasible;
+    r.detail = "worst response/deadline " + num6(worst) + " (" + tasks[worst_task].id + ")";
+    return r;
+}
+
+} // namespace rt_detail
+
+// Runs the tests that apply to `policy`; the verdict is the first conclusive one.
+inline RtAnalysis analyzeTaskSet(const std::vector<PeriodicTask>& tasks, RtPolicy policy) {
+    RtAnalysis a;
+    if (policy == RtPolicy::Edf) {
+        a.tests.push_back(rt_detail::edfUtilization(tasks));
+        if (a.tests.back().verdict == Verdict::Inconclusive) a.tests.push_back(rt_detail::edfDemand(tasks));
+    } else {
+        a.tests.push_back(rt_detail::liuLayland(tasks, policy));
+        if (a.tests.back().verdict == Verdict::Inconclusive) a.tests.push_back(rt_detail::responseTime(tasks, policy));
+    }
+    for (const auto& t : a.tests)
+        if (t.verdict != Verdict::Inconclusive) { a.verdict = t.verdict; a.decided_by = t.name; break; }
+    return a;
+}
+
+inline void printRtAnalysis(std::ostream& out, const std::vector<PeriodicTask>& tasks, const RtAnalysis& a) {
+    OutBuffer b(out);
+    b.put("Tasks: ").num((long long)tasks.size()).put(", utilization ").num6(utilization(tasks)).put('\n');
+    for (const auto& t : a.tests)
+        b.put(t.name).put(": ").put(verdictName(t.verdict)).put(" (").put(t.detail).put(")\n");
+    b.put("Verdict: ").put(verdictName(a.verdict)).put('\n');
+}
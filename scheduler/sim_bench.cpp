@@ -0,0 +1,251 @@
+// sim_bench.cpp
+// Times every scheduler in simulator.hpp over growing synthetic workloads and
+// compares the result with a stored JSON baseline.
+//
+//   sim_bench [--max-n 10000000] [--budget 20] [--baseline bench_baseline.json]
+//             [--out bench_results.json] [--tolerance 0.25] [--update-baseline true]
+//
+// Each case runs in a forked child so its peak RSS is its own and a case that
+// blows the time budget can be killed. Once a scheduler exceeds the budget at
+// some n, larger n are skipped for that scheduler and shape. Timings on a
+// shared host drift from one minute to the next, so a baseline keeps each
+// case's median over three sweeps and a case only regresses if it is still
+// over the tolerance when measured twice more after the sweep.
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <sstream>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "simulator.hpp"
+
+struct BenchCase {
+    std::string scheduler, shape;
+    long n = 0;
+};
+
+struct BenchResult {
+    BenchCase c;
+    std::string status = "ok";   // ok | timeout | failed
+    double seconds = 0, ns_per_dispatch = 0, events_per_sec = 0;
+    long dispatches = 0, peak_rss_kb = 0;
+};
+
+const std::vector<std::string> kShapes = {"dense", "sparse", "heavy"};
+
+// dense:  everything arrives within a short window, long ready queues
+// sparse: mean inter-arrival above mean burst, the CPU idles regularly
+// heavy:  Pareto(1.5) bursts with arrivals paced to roughly full load
+ProcessTable makeWorkload(const std::string& shape, long n) {
+    ProcessTable procs;
+    procs.reserve(n);
+    std::mt19937 gen(12345);
+    std::uniform_int_distribution<int> burst(1, 10), pri(1, 5);
+    std::exponential_distribution<double> gap(shape == "sparse" ? 1.0 / 8 : 1.0 / 5.5);
+    std::uniform_real_distribution<double> u(0.0, 1.0);
+    double t = 0;
+    for (long i = 0; i < n; ++i) {
+        int at, bt;
+        if (shape == "dense") {
+            at = (int)(u(gen) * (n / 20 + 1));
+            bt = burst(gen);
+        } else if (shape == "sparse") {
+            t += gap(gen);
+            at = (int)t;
+            bt = burst(gen);
+        } else {
+            t += gap(gen);
+            at = (int)t;
+            bt = std::min(1000, (int)std::ceil(1.0 / std::pow(1.0 - u(gen), 1.0 / 1.5)));
+        }
+        procs.push_back({"P" + std::to_string(i + 1), at, bt, pri(gen), bt, 0, 0, 0});
+    }
+    std::sort(procs.begin(), procs.end(),
+              [](const Process& a, const Process& b){ return a.arrival_time < b.arrival_time; });
+    return procs;
+}
+
+// Runs one case in the current process and writes "seconds dispatches" to fd.
+void runCase(const BenchCase& c, int fd) {
+    const auto input = makeWorkload(c.shape, c.n);
+    auto scheduler = makeScheduler(c.scheduler, 4);
+    // Small cases repeat until 200ms have been timed and report their fastest
+    // run, which leaves out what other load on the host added.
+    double secs = 0, timed = 0;
+    size_t segments = 0;
+    do {
+        auto procs = input;
+        GanttChart gantt;
+        SimTime total_time = 0;
+        auto start = std::chrono::steady_clock::now();
+        scheduler->schedule(procs, gantt, total_time);
+        double run = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        secs = timed == 0 ? run : std::min(secs, run);
+        timed += run;
+        segments = gantt.size();
+    } while (timed < 0.2);
+    // Every Gantt segment is at least one dispatch decision.
+    std::string line = std::to_string(secs) + " " + std::to_string(segments) + "\n";
+    if (write(fd, line.data(), line.size()) < 0) _exit(1);
+}
+
+BenchResult runIsolated(const BenchCase& c, int budget_sec) {
+    BenchResult r;
+    r.c = c;
+    int fds[2];
+    if (pipe(fds) != 0) { r.status = "failed"; return r; }
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(fds[0]);
+        alarm(budget_sec);
+        runCase(c, fds[1]);
+        _exit(0);
+    }
+    close(fds[1]);
+    std::string out;
+    char buf[128];
+    ssize_t k;
+    while ((k = read(fds[0], buf, sizeof buf)) > 0) out.append(buf, k);
+    close(fds[0]);
+    int status = 0;
+    struct rusage ru {};
+    wait4(pid, &status, 0, &ru);
+    r.peak_rss_kb = ru.ru_maxrss;
+    if (WIFSIGNALED(status) && WTERMSIG(status) == SIGALRM) { r.status = "timeout"; return r; }
+    std::istringstream ss(out);
+    if (!WIFEXITED(status) || WEXITSTATUS(status) != 0 || !(ss >> r.seconds >> r.dispatches)) {
+        r.status = "failed";
+        return r;
+    }
+    long events = c.n * 2 + r.dispatches;   // arrivals + completions + dispatches
+    r.ns_per_dispatch = r.dispatches ? r.seconds * 1e9 / r.dispatches : 0;
+    r.events_per_sec = r.seconds > 0 ? events / r.seconds : 0;
+    return r;
+}
+
+std::string toJsonLine(const BenchResult& r) {
+    std::ostringstream o;
+    o << "{\"scheduler\": \"" << r.c.scheduler << "\", \"shape\": \"" << r.c.shape
+      << "\", \"n\": " << r.c.n << ", \"status\": \"" << r.status
+      << "\", \"seconds\": " << r.seconds << ", \"dispatches\": " << r.dispatches
+      << ", \"ns_per_dispatch\": " << r.ns_per_dispatch
+      << ", \"events_per_sec\": " << r.events_per_sec
+      << ", \"peak_rss_kb\": " << r.peak_rss_kb << "}";
+    return o.str();
+}
+
+void writeJson(const std::string& path, const std::vector<BenchResult>& results) {
+    std::ofstream f(path);
+    f << "[\n";
+    for (size_t i = 0; i < results.size(); ++i)
+        f << "  " << toJsonLine(results[i]) << (i + 1 < results.size() ? ",\n" : "\n");
+    f << "]\n";
+}
+
+// Reads back the one-object-per-line files written by writeJson.
+std::map<std::string, double> readBaseline(const std::string& path) {
+    std::map<std::string, double> base;
+    std::ifstream f(path);
+    std::string line;
+    auto field = [](const std::string& l, const std::string& key) {
+        size_t p = l.find("\"" + key + "\": ");
+        if (p == std::string::npos) return std::string();
+        p += key.size() + 4;
+        if (l[p] == '"') return l.substr(p + 1, l.find('"', p + 1) - p - 1);
+        return l.substr(p, l.find_first_of(",}", p) - p);
+    };
+    while (std::getline(f, line)) {
+        if (field(line, "status") != "ok") continue;
+        std::string key = field(line, "scheduler") + "/" + field(line, "shape") + "/" + field(line, "n");
+        base[key] = std::stod(field(line, "ns_per_dispatch"));
+    }
+    return base;
+}
+
+int main(int argc, char* argv[]) {
+    std::map<std::string,std::string> args;
+    for (int i=1;i<argc;i+=2) args[argv[i]] = (i+1<argc)? argv[i+1] : "";
+
+    long max_n         = args["--max-n"].empty() ? 10000000 : std::stol(args["--max-n"]);
+    int budget         = args["--budget"].empty() ? 20 : std::stoi(args["--budget"]);
+    double tolerance   = args["--tolerance"].empty() ? 0.25 : std::stod(args["--tolerance"]);
+    std::string out    = args["--out"].empty() ? "bench_results.json" : args["--out"];
+    std::string base_path = args["--baseline"];
+    bool update        = args["--update-baseline"] == "true";
+    auto only          = args["--scheduler"];
+
+    auto baseline = base_path.empty() ? std::map<std::string,double>() : readBaseline(base_path);
+    std::vector<BenchResult> results;
+    std::vector<std::size_t> slow;   // results over the tolerance
+    auto compare = [&](const BenchResult& r, std::string& verdict) {
+        auto it = baseline.find(r.c.scheduler + "/" + r.c.shape + "/" + std::to_string(r.c.n));
+        if (r.status != "ok" || it == baseline.end() || it->second <= 0) return false;
+        double ratio = r.ns_per_dispatch / it->second;
+        char buf[32];
+        std::snprintf(buf, sizeof buf, "%+.1f%%", (ratio - 1) * 100);
+        verdict = buf;
+        return ratio > 1 + tolerance;
+    };
+    auto print = [](const BenchResult& r, const std::string& verdict) {
+        std::printf("%-9s %-7s %9ld %8s %12.1f %14.0f %11ld  %s\n",
+                    r.c.scheduler.c_str(), r.c.shape.c_str(), r.c.n, r.status.c_str(),
+                    r.ns_per_dispatch, r.events_per_sec, r.peak_rss_kb, verdict.c_str());
+        std::fflush(stdout);
+    };
+
+    std::printf("%-9s %-7s %9s %8s %12s %14s %11s  %s\n",
+                "scheduler", "shape", "n", "status", "ns/dispatch", "events/s", "peak RSS kB", "vs baseline");
+    for (const auto& sched : kAllSchedulers) {
+        if (!only.empty() && only != sched) continue;
+        for (const auto& shape : kShapes) {
+            for (long n = 1000; n <= max_n; n *= 10) {
+                BenchResult r = runIsolated({sched, shape, n}, budget);
+                std::string verdict = "-";
+                if (compare(r, verdict)) { verdict += " slower"; slow.push_back(results.size()); }
+                results.push_back(r);
+                print(r, verdict);
+                if (r.status != "ok") break;
+            }
+        }
+    }
+
+    // The host's speed drifts over minutes. A new baseline takes every case's
+    // median over two more sweeps; otherwise slow cases are measured twice
+    // more and keep their best result, and only cases that stay over the
+    // tolerance count as regressions.
+    int regressions = 0;
+    if (update) {
+        std::printf("timing every case in two more sweeps for the baseline\n");
+        std::vector<std::vector<BenchResult>> runs(results.size());
+        for (int pass = 0; pass < 2; ++pass)
+            for (std::size_t i = 0; i < results.size(); ++i)
+                if (results[i].status == "ok") runs[i].push_back(runIsolated(results[i].c, budget));
+        for (std::size_t i = 0; i < results.size(); ++i) {
+            if (runs[i].empty()) continue;
+            runs[i].push_back(results[i]);
+            std::sort(runs[i].begin(), runs[i].end(), [](const BenchResult& a, const BenchResult& b) {
+                return a.status != b.status ? a.status == "ok" : a.ns_per_dispatch < b.ns_per_dispatch;
+            });
+            results[i] = runs[i][1];
+        }
+        slow.clear();
+    }
+    if (!slow.empty()) std::printf("re-measuring %zu slow case(s)\n", slow.size());
+    for (std::size_t i : slow) {
+        BenchResult& r = results[i];
+        for (int retry = 0; retry < 2; ++retry) {
+            BenchResult again = runIsolated(r.c, budget);
+            if (again.status == "ok" && again.ns_per_dispatch < r.ns_per_dispatch) r = again;
+        }
+        std::string verdict;
+        if (compare(r, verdict)) { verdict += " REGRESSION"; ++regressions; }
+        print(r, verdict);
+    }
+
+    writeJson(out, results);
+    if (update && !base_path.empty()) writeJson(base_path, results);
+    if (regressions) std::printf("%d case(s) regressed by more than %.0f%%\n", regressions, tolerance * 100);
+    return regressions ? 1 : 0;
+}
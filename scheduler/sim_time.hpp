@@ -0,0 +1,20 @@
+// sim_time.hpp
+// The simulated time type, shared by the process model and the I/O phases.
+#pragma once
+#include <cstdint>
+#include <limits>
+
+// Simulated time. Build with -DSIM_TIME_BITS=32 for compact process tables
+// and Gantt charts on small runs; the 64-bit default takes long traces at
+// fine resolution (microseconds over days and beyond).
+#ifndef SIM_TIME_BITS
+#define SIM_TIME_BITS 64
+#endif
+#if SIM_TIME_BITS == 32
+using SimTime = std::int32_t;
+#elif SIM_TIME_BITS == 64
+using SimTime = std::int64_t;
+#else
+#error "SIM_TIME_BITS must be 32 or 64"
+#endif
+constexpr SimTime kMaxSimTime = std::numeric_limits<SimTime>::max();
@@ -1,471 +1,375 @@
-#include <iostream>
-#include <vector>
-#include <queue>
-#include <algorithm>
-#include <string>
-#include <fstream>
-#include <random>
-#include <chrono>
-#include <map>
-#include <memory>
-
-struct Process {
-    std::string id;
-    int arrival_time;
-    int burst_time;
-    int priority;
-    int remaining_time;
-    int waiting_time = 0;
-    int turnaround_time = 0;
-    int deadline = 0;
-};
-
-void calculateMetrics(const std::vector<Process>& processes, int total_time, double& avg_wait, double& avg_turn, double& cpu_util, double& throughput) {
-    avg_wait = 0;
-    avg_turn = 0;
-    for (const auto& p : processes) {
-        avg_wait += p.waiting_time;
-        avg_turn += p.turnaround_time;
-    }
-    int n = processes.size();
-    avg_wait /= n;
-    avg_turn /= n;
-    cpu_util = (total_time > 0) ? (double)std::accumulate(processes.begin(), processes.end(), 0, [](int sum, const Process& p){return sum + p.burst_time; }) / total_time * 100 : 0;
-    throughput = (double)n / total_time;
-}
-
-void printGantt(const std::vector<std::pair<std::string, int>>& gantt) {
-    std::cout << "Gantt Chart: ";
-    for (const auto& entry : gantt) {
-        std::cout << entry.first << "(" << entry.second << ") ";
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <functional>
+#include <sstream>
+#include <filesystem>
+#include <csignal>
+
+#include "simulator.hpp"
+#include "smp.hpp"
+#include "gantt_view.hpp"
+#include "gantt_index.hpp"
+#include "rt.hpp"
+#include "schedulability.hpp"
+#include "generate.hpp"
+#include "whatif.hpp"
+
+// Fixed set of tasks spread over per-worker deques. Each worker drains its own
+// deque from the front and, once empty, steals from the back of the others.
+// No task submits new work, so a worker may exit once every deque is empty.
+class WorkStealingPool {
+    struct Worker { std::mutex m; std::deque<std::function<void()>> tasks; };
+    std::vector<std::unique_ptr<Worker>> workers;
+    size_t next = 0;
+
+    bool popOwn(size_t w, std::function<void()>& task) {
+        std::lock_guard<std::mutex> lock(workers[w]->m);
+        if (workers[w]->tasks.empty()) return false;
+        task = std::move(workers[w]->tasks.front());
+        workers[w]->tasks.pop_front();
+        return true;
     }
-    std::cout << "\n";
-}
-
-void printResults(const std::vector<Process>& processes,
-                  int total_time,
-                  const std::vector<std::pair<std::string, int>>& gantt) {
-    double avg_wait, avg_turn, cpu_util, throughput;
-    calculateMetrics(processes, total_time, avg_wait, avg_turn, cpu_util, throughput);
-
-    printGantt(gantt);
-    std::cout << "Average Waiting Time: " << avg_wait << "\n";
-    std::cout << "Average Turnaround Time: " << avg_turn << "\n";
-    std::cout << "CPU Utilization: " << cpu_util << "%\n";
-    std::cout << "Throughput: " << throughput << " processes/unit time\n";
-}
-
-class Scheduler {
-public:
-    virtual ~Scheduler() = default;
-    virtual void schedule(std::vector<Process>& processes,
-                          std::vector<std::pair<std::string, int>>& gantt,
-                          int& total_time) = 0;
-};
-
-class FCFSScheduler : public Scheduler {
-public:
-    void schedule(std::vector<Process>& procs,
-                  std::vector<std::pair<std::string,int>>& gantt,
-                  int& total_time) override {
-        std::sort(procs.begin(), procs.end(),
-                  [](const Process& a, const Process& b){
-                      return a.arrival_time < b.arrival_time;
-                  });
-        int t = 0;
-        for (auto& p : procs) {
-            if (t < p.arrival_time) { gantt.emplace_back("IDLE", p.arrival_time - t); t = p.arrival_time; }
-            gantt.emplace_back(p.id, p.burst_time);
-            t += p.burst_time;
-            p.turnaround_time = t - p.arrival_time;
-            p.waiting_time    = p.turnaround_time - p.burst_time;
+    bool steal(size_t thief, std::function<void()>& task) {
+        for (size_t k = 1; k < workers.size(); ++k) {
+            auto& victim = *workers[(thief + k) % workers.size()];
+            std::lock_guard<std::mutex> lock(victim.m);
+            if (victim.tasks.empty()) continue;
+            task = std::move(victim.tasks.back());
+            victim.tasks.pop_back();
+            return true;
         }
-        total_time = t;
+        return false;
     }
-};
 
-class SJFScheduler : public Scheduler {
 public:
-    void schedule(std::vector<Process>& procs,
-                  std::vector<std::pair<std::string,int>>& gantt,
-                  int& total_time) override {
-        std::sort(procs.begin(), procs.end(),
-                  [](const Process& a, const Process& b){ return a.arrival_time < b.arrival_time; });
-        int t = 0, n = (int)procs.size(), done = 0;
-        std::vector<int> used(n, 0);
-        while (done < n) {
-            int idx = -1, best = 1e9;
-            for (int i = 0; i < n; ++i)
-                if (!used[i] && procs[i].arrival_time <= t && procs[i].burst_time < best)
-                    best = procs[i].burst_time, idx = i;
-            if (idx == -1) {
-                int next_arr = 1e9;
-                for (int i = 0; i < n; ++i) if (!used[i]) next_arr = std::min(next_arr, procs[i].arrival_time);
-                gantt.emplace_back("IDLE", next_arr - t); t = next_arr; continue;
-            }
-            auto& p = procs[idx];
-            gantt.emplace_back(p.id, p.burst_time);
-            t += p.burst_time;
-            p.turnaround_time = t - p.arrival_time;
-            p.waiting_time    = p.turnaround_time - p.burst_time;
-            used[idx] = 1; ++done;
+    explicit WorkStealingPool(unsigned n) {
+        for (unsigned i = 0; i < std::max(1u, n); ++i) workers.push_back(std::make_unique<Worker>());
+    }
+    // Submit before run(); tasks are dealt round-robin.
+    void submit(std::function<void()> task) {
+        workers[next++ % workers.size()]->tasks.push_back(std::move(task));
+    }
+    void run() {
+        std::vector<std::thread> threads;
+        for (size_t w = 0; w < workers.size(); ++w) {
+            threads.emplace_back([this, w]{
+                std::function<void()> task;
+                while (popOwn(w, task) || steal(w, task)) task();
+            });
         }
-        total_time = t;
+        for (auto& th : threads) th.join();
     }
 };
 
-class SRTFScheduler : public Scheduler {
+struct BatchResult {
+    std::string workload, scheduler, error;
+    size_t processes = 0;
+    long long total_time = 0;
+    MetricsAccumulator metrics;
+    long long peak_bytes = 0;   // tracked container bytes above what was live at start
+};
+
+// Streams one row per finished (workload, scheduler) pair; rows arrive in
+// completion order, so every row carries its own keys.
+class BatchWriter {
+    std::ostream& out;
+    bool json;
+    bool first = true;
+    std::mutex m;
 public:
-    void schedule(std::vector<Process>& procs,
-                  std::vector<std::pair<std::string,int>>& gantt,
-                  int& total_time) override {
-        for (auto& p : procs) p.remaining_time = p.burst_time;
-        std::sort(procs.begin(), procs.end(),
-                  [](const Process& a, const Process& b){ return a.arrival_time < b.arrival_time; });
-        int t = 0, n = (int)procs.size(), finished = 0;
-        std::string last = "IDLE"; int run = 0;
-        while (finished < n) {
-            int idx = -1, best = 1e9;
-            for (int i = 0; i < n; ++i)
-                if (procs[i].arrival_time <= t && procs[i].remaining_time > 0 &&
-                    procs[i].remaining_time < best) best = procs[i].remaining_time, idx = i;
-            if (idx == -1) {
-                if (last != "IDLE") { if (run) gantt.emplace_back(last, run); last = "IDLE"; run = 0; }
-                ++t; ++run; continue;
-            }
-            if (last != procs[idx].id) { if (run) gantt.emplace_back(last, run); last = procs[idx].id; run = 0; }
-            ++run; --procs[idx].remaining_time; ++t;
-            if (procs[idx].remaining_time == 0) {
-                procs[idx].turnaround_time = t - procs[idx].arrival_time;
-                procs[idx].waiting_time    = procs[idx].turnaround_time - procs[idx].burst_time;
-                ++finished;
-            }
+    BatchWriter(std::ostream& o, bool as_json) : out(o), json(as_json) {
+        if (json) out << "[\n";
+        else out << "workload,scheduler,processes,total_time,avg_wait,avg_turnaround,cpu_util,throughput,"
+                    "p95_wait,p99_wait,max_wait,p99_response,switch_overhead,peak_bytes,error\n";
+    }
+    ~BatchWriter() { if (json) out << (first ? "" : "\n") << "]\n"; out.flush(); }
+
+    // Workload paths, scheduler names and errors quoted for JSON or CSV.
+    static std::string quoted(std::string_view s, bool as_json) {
+        std::ostringstream o;
+        {
+            OutBuffer b(o);
+            if (as_json) results_detail::jsonString(b, s);
+            else results_detail::csvField(b, s);
         }
-        if (run) gantt.emplace_back(last, run);
-        total_time = t;
+        return o.str();
     }
-};
 
-class PriorityScheduler : public Scheduler {
-public:
-    void schedule(std::vector<Process>& procs,
-                  std::vector<std::pair<std::string,int>>& gantt,
-                  int& total_time) override {
-        std::sort(procs.begin(), procs.end(),
-                  [](const Process& a, const Process& b){ return a.arrival_time < b.arrival_time; });
-        int t = 0, n = (int)procs.size(), done = 0;
-        std::vector<int> used(n, 0);
-        while (done < n) {
-            int idx = -1, bestP = 1e9;
-            for (int i = 0; i < n; ++i)
-                if (!used[i] && procs[i].arrival_time <= t && procs[i].priority < bestP)
-                    bestP = procs[i].priority, idx = i;
-            if (idx == -1) {
-                int next_arr = 1e9;
-                for (int i = 0; i < n; ++i) if (!used[i]) next_arr = std::min(next_arr, procs[i].arrival_time);
-                gantt.emplace_back("IDLE", next_arr - t); t = next_arr; continue;
-            }
-            auto& p = procs[idx];
-            gantt.emplace_back(p.id, p.burst_time);
-            t += p.burst_time;
-            p.turnaround_time = t - p.arrival_time;
-            p.waiting_time    = p.turnaround_time - p.burst_time;
-            used[idx] = 1; ++done;
+    void write(const BatchResult& r) {
+        const MetricsAccumulator& mt = r.metrics;
+        std::string workload = quoted(r.workload, json), scheduler = quoted(r.scheduler, json),
+                    error = quoted(r.error, json);
+        std::ostringstream row;
+        if (json) {
+            row << "  {\"workload\": " << workload << ", \"scheduler\": " << scheduler
+                << ", \"processes\": " << r.processes << ", \"total_time\": " << r.total_time
+                << ", \"avg_wait\": " << mt.avgWait() << ", \"avg_turnaround\": " << mt.avgTurnaround()
+                << ", \"cpu_util\": " << mt.cpuUtilization() << ", \"throughput\": " << mt.throughput()
+                << ", \"p95_wait\": " << mt.waiting().quantile(0.95) << ", \"p99_wait\": " << mt.waiting().quantile(0.99)
+                << ", \"max_wait\": " << mt.maxWait() << ", \"p99_response\": " << mt.response().quantile(0.99)
+                << ", \"switch_overhead\": " << mt.overheadTime()
+                << ", \"peak_bytes\": " << r.peak_bytes << ", \"error\": " << error << "}";
+        } else {
+            row << workload << "," << scheduler << "," << r.processes << "," << r.total_time << ","
+                << mt.avgWait() << "," << mt.avgTurnaround() << "," << mt.cpuUtilization() << "," << mt.throughput() << ","
+                << mt.waiting().quantile(0.95) << "," << mt.waiting().quantile(0.99) << "," << mt.maxWait() << ","
+                << mt.response().quantile(0.99) << "," << mt.overheadTime() << "," << r.peak_bytes << "," << error << "\n";
         }
-        total_time = t;
+        // The separator is decided under the lock: rows arrive from every worker
+        std::lock_guard<std::mutex> lock(m);
+        if (json && !first) out << ",\n";
+        out << row.str();
+        first = false;
     }
 };
 
-class RoundRobinScheduler : public Scheduler {
-private:
-    int quantum;
-
-public:
-    explicit RoundRobinScheduler(int q) : quantum(q) {}
-
-    void schedule(std::vector<Process>& processes,
-                  std::vector<std::pair<std::string, int>>& gantt,
-                  int& total_time) override {
-        // Initialize remaining time
-        for (auto& p : processes) p.remaining_time = p.burst_time;
-
-        // Ensure sorted by arrival for streaming arrivals into ready_queue
-        std::stable_sort(processes.begin(), processes.end(),
-                         [](const Process& a, const Process& b) {
-                             return a.arrival_time < b.arrival_time;
-                         });
-
-        std::queue<Process*> ready_queue;
-        int current_time = 0;
-        int idx = 0;  // index for processes (arrivals)
-
-        // Helper: add all arrivals up to current_time
-        auto add_arrivals = [&](int t) {
-            while (idx < (int)processes.size() && processes[idx].arrival_time <= t) {
-                ready_queue.push(&processes[idx++]);
-            }
-        };
-
-        add_arrivals(0);
-
-        std::string last_id = "";
-        int last_start = -1;
-
-        while (!ready_queue.empty() || idx < (int)processes.size()) {
-            if (ready_queue.empty()) {
-                // Idle time: advance to next arrival
-                if (idx < (int)processes.size()) current_time = processes[idx].arrival_time;
-                add_arrivals(current_time);
-                continue;
-            }
-
-            Process* current = ready_queue.front();
-            ready_queue.pop();
-
-            int run_time = std::min(quantum, current->remaining_time);
+// Manifest lines: "<workload> [scheduler ...]"; '#' starts a comment and
+// relative paths are taken from the manifest's directory. A directory batches
+// every regular file in it. Pairs without schedulers use `defaults`.
+std::vector<std::pair<std::string, std::vector<std::string>>>
+readBatchManifest(const std::string& path, const std::vector<std::string>& defaults) {
+    namespace fs = std::filesystem;
+    std::vector<std::pair<std::string, std::vector<std::string>>> entries;
+    std::error_code ec;
+    if (fs::is_directory(path, ec)) {
+        for (const auto& e : fs::directory_iterator(path, ec))
+            if (e.is_regular_file()) entries.emplace_back(e.path().string(), defaults);
+        std::sort(entries.begin(), entries.end());
+        return entries;
+    }
+    std::ifstream file(path);
+    if (!file) { std::cerr << "Error opening manifest: " << path << "\n"; return entries; }
+    fs::path base = fs::path(path).parent_path();
+    std::string line;
+    while (std::getline(file, line)) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream ss(line);
+        std::string workload, s;
+        if (!(ss >> workload)) continue;
+        std::vector<std::string> scheds;
+        while (ss >> s) scheds.push_back(s);
+        fs::path wp(workload);
+        if (wp.is_relative()) wp = base / wp;
+        entries.emplace_back(wp.string(), scheds.empty() ? defaults : scheds);
+    }
+    return entries;
+}
 
-            // Commit previous segment if context switched
-            if (last_id != current->id || last_start == -1) {
-                if (last_start != -1) {
-                    gantt.emplace_back(last_id, current_time - last_start);
+int runBatch(const std::string& manifest, const std::vector<std::string>& defaults,
+             int quantum, const SmpOptions& smp, unsigned threads, const std::string& out_path) {
+    auto entries = readBatchManifest(manifest, defaults);
+    if (entries.empty()) { std::cerr << "Batch manifest is empty: " << manifest << "\n"; return 1; }
+
+    // Each workload is parsed once, by whichever task needs it first.
+    struct Workload {
+        std::string path;
+        std::once_flag loaded;
+        ProcessTable procs;
+        IoWorkload io;
+        GroupTree groups;
+        uintmax_t bytes = 0;
+    };
+    std::vector<std::unique_ptr<Workload>> workloads;
+    struct Task { Workload* w; std::string sched; };
+    std::vector<Task> tasks;
+    for (auto& [path, scheds] : entries) {
+        workloads.push_back(std::make_unique<Workload>());
+        workloads.back()->path = path;
+        std::error_code ec;
+        workloads.back()->bytes = std::filesystem::file_size(path, ec);
+        for (auto& s : scheds) tasks.push_back({workloads.back().get(), s});
+    }
+    // Deal largest workloads first so every worker starts on big files and
+    // stealing evens out the small ones at the end.
+    std::stable_sort(tasks.begin(), tasks.end(),
+                     [](const Task& a, const Task& b){ return a.w->bytes > b.w->bytes; });
+
+    std::ofstream file;
+    if (!out_path.empty()) {
+        file.open(out_path);
+        if (!file) { std::cerr << "Could not open output file: " << out_path << "\n"; return 1; }
+    }
+    std::ostream& out = out_path.empty() ? std::cout : file;
+    bool json = out_path.size() >= 5 && out_path.compare(out_path.size() - 5, 5, ".json") == 0;
+
+    std::atomic<int> failures{0};
+    // Per-scheduler metrics merged over every workload, written as "*" rows.
+    std::map<std::string, BatchResult> merged;
+    std::mutex merged_m;
+    {
+        BatchWriter writer(out, json);
+        WorkStealingPool pool(threads);
+        for (auto& task : tasks) {
+            pool.submit([&writer, &failures, &merged, &merged_m, &smp, task, quantum]{
+                BatchResult r;
+                r.workload = task.w->path;
+                r.scheduler = task.sched;
+                std::call_once(task.w->loaded, [&]{ task.w->procs = loadProcesses(task.w->path, &task.w->io, &task.w->groups); });
+                SmpOptions opt = smp;
+                if (!task.w->io.empty()) opt.io = &task.w->io;
+                if (!task.w->groups.empty()) opt.groups = &task.w->groups;
+                auto scheduler = makeScheduler(task.sched, quantum, opt);
+                if (!scheduler) r.error = "unknown scheduler";
+                else if (task.w->procs.empty()) r.error = "no processes";
+                else {
+                    memAccount().resetPeaks();
+                    long long start_bytes = memAccount().live();
+                    ProcessTable procs = task.w->procs;
+                    GanttChart gantt;
+                    SimTime total_time = 0;
+                    scheduler->schedule(procs, gantt, total_time);
+                    r.processes = procs.size();
+                    r.total_time = total_time;
+                    r.peak_bytes = memAccount().peak() - start_bytes;
+                    r.metrics = scheduler->metrics();
+                    std::lock_guard<std::mutex> lock(merged_m);
+                    BatchResult& all = merged[r.scheduler];
+                    all.processes += r.processes;
+                    all.total_time += r.total_time;
+                    all.peak_bytes = std::max(all.peak_bytes, r.peak_bytes);
+                    all.metrics.merge(r.metrics);
                 }
-                last_id = current->id;
-                last_start = current_time;
-            }
-
-            current->remaining_time -= run_time;
-            current_time += run_time;
-
-            // Add newly arrived during this slice
-            add_arrivals(current_time);
-
-            if (current->remaining_time > 0) {
-                ready_queue.push(current);
-            } else {
-                current->turnaround_time = current_time - current->arrival_time;
-                current->waiting_time = current->turnaround_time - current->burst_time;
-            }
+                if (!r.error.empty()) ++failures;
+                writer.write(r);
+            });
         }
-
-        if (last_start != -1) {
-            gantt.emplace_back(last_id, current_time - last_start);
+        pool.run();
+        for (auto& [sched, all] : merged) {
+            all.workload = "*";
+            all.scheduler = sched;
+            writer.write(all);
         }
-        total_time = current_time;
     }
-};
+    return failures ? 1 : 0;
+}
 
-class MLQScheduler : public Scheduler {
-public:
-    void schedule(std::vector<Process>& procs,
-                  std::vector<std::pair<std::string,int>>& gantt,
-                  int& total_time) override {
-        int t = 0;
-        std::queue<int> high, low;
-        for (int i = 0; i < (int)procs.size(); ++i) {
-            if (procs[i].priority < 3) high.push(i); else low.push(i);
-        }
-        for (auto& p : procs) p.remaining_time = p.burst_time;
-        while (!high.empty() || !low.empty()) {
-            if (!high.empty()) {
-                int i = high.front(); high.pop();
-                auto& p = procs[i];
-                int slice = std::min(4, p.remaining_time);
-                gantt.emplace_back(p.id, slice);
-                t += slice; p.remaining_time -= slice;
-                if (p.remaining_time > 0) high.push(i);
-                else { p.turnaround_time = t - p.arrival_time; p.waiting_time = p.turnaround_time - p.burst_time; }
-            } else {
-                int i = low.front(); low.pop();
-                auto& p = procs[i];
-                gantt.emplace_back(p.id, p.burst_time);
-                t += p.burst_time;
-                p.turnaround_time = t - p.arrival_time;
-                p.waiting_time    = p.turnaround_time - p.burst_time;
-            }
-        }
-        total_time = t;
-    }
-};
+// SIGUSR1 dumps every thread's trace ring on demand; SIGABRT (failed assert)
+// dumps them before the process dies.
+extern "C" void dumpTraceOnSignal(int sig) {
+    traceRings().dump(g_trace_dump_path);
+    if (sig == SIGABRT) { std::signal(SIGABRT, SIG_DFL); std::raise(SIGABRT); }
+}
 
-class MLFQScheduler : public Scheduler {
-public:
-    void schedule(std::vector<Process>& procs,
-                  std::vector<std::pair<std::string,int>>& gantt,
-                  int& total_time) override {
-        std::vector<std::queue<int>> qs(3);
-        std::vector<int> quanta = {2,4,8};
-        for (int i = 0; i < (int)procs.size(); ++i) { qs[0].push(i); procs[i].remaining_time = procs[i].burst_time; }
-        int t = 0;
-        while (true) {
-            int lvl = -1;
-            for (int l=0;l<3;++l) if (!qs[l].empty()) { lvl = l; break; }
-            if (lvl == -1) break;
-            int i = qs[lvl].front(); qs[lvl].pop();
-            auto& p = procs[i];
-            int slice = std::min(quanta[lvl], p.remaining_time);
-            gantt.emplace_back(p.id, slice);
-            p.remaining_time -= slice; t += slice;
-            if (p.remaining_time == 0) {
-                p.turnaround_time = t - p.arrival_time;
-                p.waiting_time    = p.turnaround_time - p.burst_time;
-            } else {
-                int nl = std::min(2, lvl+1);
-                qs[nl].push(i);
-            }
-        }
-        total_time = t;
-    }
-};
+std::vector<std::string> splitList(const std::string& s) {
+    std::vector<std::string> out;
+    std::istringstream ss(s);
+    std::string item;
+    while (std::getline(ss, item, ',')) if (!item.empty()) out.push_back(item);
+    return out;
+}
 
-class LotteryScheduler : public Scheduler {
-public:
-    void schedule(std::vector<Process>& procs,
-                  std::vector<std::pair<std::string,int>>& gantt,
-                  int& total_time) override {
-        for (auto& p : procs) p.remaining_time = p.burst_time;
-        std::mt19937 gen(42);
-        int t = 0;
-        int left = 0; for (auto& p : procs) left += p.remaining_time;
-        while (left > 0) {
-            std::vector<int> tickets(procs.size(),0);
-            int total = 0;
-            for (int i=0;i<(int)procs.size();++i) if (procs[i].remaining_time>0) {
-                int tk = std::max(1, 10 / std::max(1, procs[i].priority));
-                tickets[i] = tk; total += tk;
-            }
-            std::uniform_int_distribution<int> dist(1,total);
-            int draw = dist(gen), winner=-1, acc=0;
-            for (int i=0;i<(int)procs.size();++i) { if (!tickets[i]) continue; acc+=tickets[i]; if (draw<=acc){ winner=i; break; } }
-            auto& p = procs[winner];
-            int slice = std::min(2, p.remaining_time);
-            gantt.emplace_back(p.id, slice);
-            p.remaining_time -= slice; t += slice; left -= slice;
-            if (p.remaining_time == 0) {
-                p.turnaround_time = t - p.arrival_time;
-                p.waiting_time    = p.turnaround_time - p.burst_time;
-            }
-        }
-        total_time = t;
+// Builds a downsampled Gantt view over `range` ("t0:t1", default the whole
+// run up to `end`) from `feed`, which adds the segments in time order, and
+// prints it as text or writes it as SVG to `svg_path`.
+template <class Feed>
+bool renderGanttView(Feed feed, long long end, const std::string& range, size_t width,
+                     const std::string& svg_path) {
+    long long t0 = 0, t1 = end;
+    if (!range.empty()) {
+        size_t colon = range.find(':');
+        if (colon == std::string::npos) { std::cerr << "Bad --gantt-range, expected t0:t1: " << range << "\n"; return false; }
+        t0 = std::stoll(range.substr(0, colon));
+        t1 = std::stoll(range.substr(colon + 1));
     }
-};
+    GanttView view(t0, t1, width ? width : svg_path.empty() ? 100 : 1200);
+    feed(view);
+    if (svg_path.empty()) { renderGanttText(std::cout, view); return true; }
+    std::ofstream svg(svg_path);
+    if (!svg) { std::cerr << "Could not open SVG file: " << svg_path << "\n"; return false; }
+    renderGanttSvg(svg, view);
+    return true;
+}
 
-class CFSScheduler : public Scheduler {
-    struct CProc { int idx; double vruntime=0.0; };
-    struct Cmp { bool operator()(const CProc& a, const CProc& b) const { return a.vruntime > b.vruntime; } };
-public:
-    void schedule(std::vector<Process>& procs,
-                  std::vector<std::pair<std::string,int>>& gantt,
-                  int& total_time) override {
-        for (auto& p : procs) p.remaining_time = p.burst_time;
-        std::priority_queue<CProc,std::vector<CProc>,Cmp> pq;
-        for (int i=0;i<(int)procs.size();++i) pq.push({i,0.0});
-        int t = 0;
-        auto weight = [&](int pr){ return 1.0 / std::max(1, pr); };
-        while (!pq.empty()) {
-            auto cp = pq.top(); pq.pop();
-            int i = cp.idx; auto& p = procs[i];
-            if (p.remaining_time==0) continue;
-            int slice = std::min(2, p.remaining_time);
-            gantt.emplace_back(p.id, slice);
-            p.remaining_time -= slice; t += slice;
-            cp.vruntime += slice / weight(p.priority);
-            if (p.remaining_time > 0) pq.push(cp);
-            else { p.turnaround_time = t - p.arrival_time; p.waiting_time = p.turnaround_time - p.burst_time; }
-        }
-        total_time = t;
+// Schedulability screening: the analytic tests for every policy, simulating
+// only the task sets they cannot decide. A directory gives one CSV row per
+// (task set, policy); a single file the full report.
+int runAnalysis(const std::string& path, const std::vector<std::string>& schedulers, long long horizon) {
+    std::vector<RtPolicy> policies;
+    for (const auto& name : schedulers) {
+        RtPolicy p;
+        if (!parseRtPolicy(name, p)) { std::cerr << "Periodic tasks need --scheduler edf, rm or dm\n"; return 1; }
+        policies.push_back(p);
     }
-};
-
-class EDFScheduler : public Scheduler {
-public:
-    void schedule(std::vector<Process>& procs,
-                  std::vector<std::pair<std::string,int>>& gantt,
-                  int& total_time) override {
-        for (auto& p : procs) { p.remaining_time = p.burst_time; if (p.deadline==0) p.deadline = p.arrival_time + 2*p.burst_time; }
-        std::sort(procs.begin(), procs.end(),
-                  [](const Process& a, const Process& b){
-                      if (a.arrival_time != b.arrival_time) return a.arrival_time < b.arrival_time;
-                      return a.id < b.id;
-                  });
-        using Key = std::tuple<int,int,int>; // (deadline, arrival, index)
-        struct Cmp { bool operator()(const Key& x, const Key& y) const { return x > y; } };
-        std::priority_queue<Key,std::vector<Key>,Cmp> pq;
-        int n = (int)procs.size(), finished = 0, t = 0, ap = 0;
-        auto push_arrivals_up_to = [&](int time){
-            while (ap < n && procs[ap].arrival_time <= time) {
-                if (procs[ap].remaining_time > 0) pq.emplace(procs[ap].deadline, procs[ap].arrival_time, ap);
-                ++ap;
-            }
-        };
-        if (ap < n && procs[ap].arrival_time > 0) { gantt.emplace_back("IDLE", procs[ap].arrival_time - t); t = procs[ap].arrival_time; }
-        push_arrivals_up_to(t);
-
-        std::string last = "IDLE"; int run = 0;
-
-        while (finished < n) {
-            if (pq.empty()) {
-                if (ap < n) {
-                    int next_t = procs[ap].arrival_time;
-                    if (last != "IDLE") { if (run) gantt.emplace_back(last, run); last="IDLE"; run=0; }
-                    gantt.emplace_back("IDLE", next_t - t);
-                    t = next_t;
-                    push_arrivals_up_to(t);
-                    continue;
-                } else break;
-            }
-            auto [dl, arr, i] = pq.top(); pq.pop();
-            if (last != procs[i].id) { if (run) gantt.emplace_back(last, run); last = procs[i].id; run = 0; }
-            // run 1 unit
-            --procs[i].remaining_time; ++run; ++t;
-            push_arrivals_up_to(t);
-            if (procs[i].remaining_time == 0) {
-                procs[i].turnaround_time = t - procs[i].arrival_time;
-                procs[i].waiting_time    = procs[i].turnaround_time - procs[i].burst_time;
-                ++finished;
-            } else {
-                pq.emplace(procs[i].deadline, procs[i].arrival_time, i);
-            }
+    if (policies.empty()) policies = {RtPolicy::Edf, RtPolicy::Rm, RtPolicy::Dm};
+    static const char* const names[] = {"edf", "rm", "dm"};
+
+    std::error_code ec;
+    if (!std::filesystem::is_directory(path, ec)) {
+        std::vector<PeriodicTask> tasks;
+        std::string error;
+        if (!loadTaskSet(path, tasks, error)) { std::cerr << error << "\n"; return 1; }
+        for (RtPolicy p : policies) {
+            RtAnalysis a = analyzeTaskSet(tasks, p);
+            std::cout << "Scheduler: " << names[(int)p] << "\n";
+            printRtAnalysis(std::cout, tasks, a);
+            if (a.verdict == Verdict::Inconclusive)
+                printRtReport(std::cout, tasks, simulatePeriodic(tasks, p, horizon ? horizon : defaultHorizon(tasks)));
         }
-        if (run) gantt.emplace_back(last, run);
-        total_time = t;
+        return 0;
     }
-};
-
-std::vector<Process> loadProcesses(const std::string& filename) {
-    std::vector<Process> procs;
-    std::ifstream file(filename);
-    if (!file) { std::cerr << "Error opening file: " << filename << "\n"; return procs; }
-    std::string id; int at, bt, pri, dl = 0;
-    // Accept 4 or 5 fields per line: ID arrival burst priority [deadline]
-    std::string line;
-    while (true) {
-        if (!(file >> id >> at >> bt >> pri)) break;
-        if (file.peek()=='\n' || file.peek()==EOF) dl = 0;
-        else {
-            // try to read optional deadline
-            std::streampos pos = file.tellg();
-            if (file >> dl) { /* ok */ }
-            else { file.clear(); file.seekg(pos); dl = 0; }
+    std::vector<std::string> files;
+    for (const auto& e : std::filesystem::directory_iterator(path, ec))
+        if (e.is_regular_file()) files.push_back(e.path().string());
+    std::sort(files.begin(), files.end());
+    OutBuffer b(std::cout);
+    b.put("task_set,scheduler,tasks,utilization,verdict,decided_by,simulated_misses\n");
+    for (const auto& file : files) {
+        std::vector<PeriodicTask> tasks;
+        std::string error;
+        if (!loadTaskSet(file, tasks, error)) { b.flush(); std::cerr << error << "\n"; continue; }
+        for (RtPolicy p : policies) {
+            RtAnalysis a = analyzeTaskSet(tasks, p);
+            b.put(file).put(',').put(names[(int)p]).put(',').num((long long)tasks.size()).put(',')
+             .num6(utilization(tasks)).put(',');
+            if (a.verdict != Verdict::Inconclusive) {
+                b.put(verdictName(a.verdict)).put(',').put(a.decided_by).put(",\n");
+                continue;
+            }
+            // A simulated miss proves infeasibility; a clean run does not prove the opposite.
+            RtRun run = simulatePeriodic(tasks, p, horizon ? horizon : defaultHorizon(tasks));
+            std::uint64_t missed = 0;
+            for (const auto& t : run.tasks) missed += t.missed;
+            b.put(missed ? "infeasible" : "inconclusive").put(",simulation,").num((long long)missed).put('\n');
         }
-        procs.push_back({id, at, bt, pri, bt, 0, 0, dl});
     }
-    std::sort(procs.begin(), procs.end(),
-              [](const Process& a, const Process& b){ return a.arrival_time < b.arrival_time; });
-    return procs;
+    return 0;
 }
 
-std::vector<Process> generateRandomProcesses(int num) {
-    std::vector<Process> procs;
-    std::mt19937 gen((unsigned)std::chrono::system_clock::now().time_since_epoch().count());
-    std::uniform_int_distribution<int> A(0, 20), B(1, 10), P(1, 5);
-    for (int i=0;i<num;++i) {
-        std::string id = "P" + std::to_string(i+1);
-        int at = A(gen), bt = B(gen), pri = P(gen);
-        procs.push_back({id, at, bt, pri, bt, 0, 0, 0});
-    }
-    std::sort(procs.begin(), procs.end(),
-              [](const Process& a, const Process& b){ return a.arrival_time < b.arrival_time; });
-    return procs;
+// What-if analysis: one baseline run of `procs`, then every scenario in
+// `path` replayed incrementally from the baseline's snapshots. One CSV row
+// each, after the baseline's; `replayed` is the simulated time run again.
+int runWhatIf(const std::string& path, const std::string& scheduler, int quantum, long long interval,
+              const ProcessTable& procs) {
+    std::vector<WhatIf> scenarios;
+    std::string error;
+    if (!loadWhatIfs(path, scenarios, error)) { std::cerr << error << "\n"; return 1; }
+    IncrementalSim sim(scheduler, quantum, procs, interval);
+    if (!sim.valid()) { std::cerr << "Unknown scheduler: " << scheduler << "\n"; return 1; }
+    auto start = std::chrono::steady_clock::now();
+    sim.baseline();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    OutBuffer b(std::cout);
+    b.put("scenario,restart,converged,replayed,total_time,avg_waiting,avg_turnaround,p99_waiting,"
+          "cpu_utilization,throughput,seconds\n");
+    auto row = [&](const std::string& name, long long restart, long long converged, long long end,
+                   const MetricsAccumulator& m, double secs) {
+        b.put(name).put(',').num(restart).put(',');
+        if (converged >= 0) b.num(converged);
+        b.put(',').num((converged >= 0 ? converged : end) - restart).put(',').num(end).put(',')
+         .num6(m.avgWait()).put(',').num6(m.avgTurnaround()).put(',').num6(m.waiting().quantile(0.99)).put(',')
+         .num6(m.cpuUtilization()).put(',').num6(m.throughput()).put(',').num6(secs).put('\n');
+    };
+    row("baseline", 0, -1, sim.baseTotal(), sim.baseMetrics(), seconds);
+    int failures = 0;
+    for (const auto& w : scenarios) {
+        WhatIfResult r;
+        if (!sim.rerun(w, r, error)) { b.flush(); std::cerr << error << "\n"; ++failures; continue; }
+        row(w.name, r.restart, r.converged, r.total_time, r.metrics, r.seconds);
+    }
+    return failures ? 1 : 0;
 }
 
 int main(int argc, char* argv[]) {
@@ -479,11 +383,131 @@ int main(int argc, char* argv[]) {
     bool random                = (args["--random"]=="--random" || args["--random"]=="true");
     int  num_rand              = args["--num"].empty()? 10 : std::stoi(args["--num"]);
     std::string output_path    = args["--output"];
+    std::string format_name    = args["--format"];
+    std::string stats_mode     = args["--stats"];
+    std::string memory_mode    = args["--memory"];
+    double progress_sec        = args["--progress"].empty()? 0 : std::stod(args["--progress"]);
+    std::string progress_path  = args["--progress-file"];
+    std::string trace_dump     = args["--trace-dump"];
+    long long window           = args["--window"].empty()? 0 : std::stoll(args["--window"]);
+    std::string window_path    = args["--window-file"];
+    std::string timeline_path  = args["--timeline"];
+    size_t gantt_width         = args["--gantt-width"].empty()? 0 : std::stoul(args["--gantt-width"]);
+    std::string gantt_range    = args["--gantt-range"];
+    std::string gantt_svg      = args["--gantt-svg"];
+    SmpOptions smp;
+    smp.cpus                   = args["--cpus"].empty()? 1 : std::stoi(args["--cpus"]);
+    smp.interval               = args["--balance-interval"].empty()? 50 : std::stoi(args["--balance-interval"]);
+    smp.threads                = args["--sim-threads"].empty()? 1 : std::stoi(args["--sim-threads"]);
+    smp.switch_cost            = args["--switch-cost"].empty()? 0 : std::stoi(args["--switch-cost"]);
+    smp.warmup                 = args["--cache-warmup"].empty()? 0 : std::stoi(args["--cache-warmup"]);
+    smp.warmup_decay           = args["--cache-decay"].empty()? 100 : std::stoi(args["--cache-decay"]);
+    smp.costed                 = !args["--switch-cost"].empty() || !args["--cache-warmup"].empty();
+    smp.predict                = args["--predict"].empty()? 0 : std::stod(args["--predict"]);
+    smp.predict_initial        = args["--predict-initial"].empty()? 10 : std::stod(args["--predict-initial"]);
+    std::string checkpoint_path = args["--checkpoint"];
+    long long checkpoint_every = args["--checkpoint-every"].empty()? 0 : std::stoll(args["--checkpoint-every"]);
+    std::string resume_path    = args["--resume"];
+    if (quantum <= 0) { std::cerr << "--quantum must be positive\n"; return 1; }
+
+    if (!args["--trace-decode"].empty())
+        return decodeTraceDump(args["--trace-decode"].c_str(), std::cout) ? 0 : 1;
+    // Synthetic workload files
+    if (!args["--generate"].empty()) {
+        GenOptions gen;
+        gen.jobs        = args["--num"].empty()? 10 : std::stoll(args["--num"]);
+        gen.utilization = args["--gen-util"].empty()? 0 : std::stod(args["--gen-util"]);
+        gen.cpus        = smp.cpus;
+        gen.seed        = args["--seed"].empty()? 1 : std::stoull(args["--seed"]);
+        gen.threads     = args["--threads"].empty()? (int)std::max(1u, std::thread::hardware_concurrency())
+                                                   : std::stoi(args["--threads"]);
+        if (!args["--gen-arrivals"].empty() && !parseArrivals(args["--gen-arrivals"], gen)) {
+            std::cerr << "Bad --gen-arrivals, expected poisson:RATE or mmpp:QUIET:BUSY:QUIET_DWELL:BUSY_DWELL\n"; return 1;
+        }
+        if (!args["--gen-burst"].empty() && !io_detail::parseDist(args["--gen-burst"], gen.burst)) {
+            std::cerr << "Bad --gen-burst distribution: " << args["--gen-burst"] << "\n"; return 1;
+        }
+        if (!args["--gen-diurnal"].empty() && !parseDiurnal(args["--gen-diurnal"], gen)) {
+            std::cerr << "Bad --gen-diurnal, expected PERIOD:AMPLITUDE with amplitude in [0, 1)\n"; return 1;
+        }
+        std::ofstream out(args["--generate"], std::ios::binary);
+        if (!out) { std::cerr << "Could not open output file: " << args["--generate"] << "\n"; return 1; }
+        std::string error;
+        if (!generateWorkload(gen, out, error)) { std::cerr << error << "\n"; return 1; }
+        return 0;
+    }
+    // Zooming into a finished run saved with --format bin
+    if (!args["--render"].empty()) {
+        LoadedResults saved;
+        if (!readResultsBin(args["--render"], saved)) { std::cerr << "Could not read results: " << args["--render"] << "\n"; return 1; }
+        auto feed = [&](GanttView& view) {
+            for (const auto& sg : saved.segments) view.add(saved.ids[sg.id], sg.start, sg.duration);
+        };
+        return renderGanttView(feed, saved.summary.total_time, gantt_range, gantt_width, gantt_svg) ? 0 : 1;
+    }
+    // Point and range queries on stdin against a run saved with --format bin
+    if (!args["--query"].empty()) {
+        LoadedResults saved;
+        if (!readResultsBin(args["--query"], saved)) { std::cerr << "Could not read results: " << args["--query"] << "\n"; return 1; }
+        runGanttQueries(buildGanttIndex(saved), std::cin, std::cout);
+        return 0;
+    }
+    if (args["--balance"] == "migrate") smp.balance = SmpOptions::Balance::Migrate;
+    else if (!args["--balance"].empty() && args["--balance"] != "steal") {
+        std::cerr << "Unknown balancer: " << args["--balance"] << "\n"; return 1;
+    }
+    if (args["--trace-ring"] == "off") traceRing().enabled = false;
+    if (!trace_dump.empty()) setTraceDumpPath(trace_dump.c_str());
+    std::signal(SIGUSR1, dumpTraceOnSignal);
+    std::signal(SIGABRT, dumpTraceOnSignal);
+
+    if (!args["--analyze"].empty())
+        return runAnalysis(args["--analyze"], splitList(scheduler_type),
+                           args["--horizon"].empty() ? 0 : std::stoll(args["--horizon"]));
+    // Periodic real-time task sets: edf (the default), rm or dm
+    if (!args["--periodic"].empty()) {
+        std::vector<PeriodicTask> tasks;
+        std::string error;
+        if (!loadTaskSet(args["--periodic"], tasks, error)) { std::cerr << error << "\n"; return 1; }
+        RtPolicy policy = RtPolicy::Edf;
+        if (!scheduler_type.empty() && !parseRtPolicy(scheduler_type, policy)) {
+            std::cerr << "Periodic tasks need --scheduler edf, rm or dm\n"; return 1;
+        }
+        long long horizon = args["--horizon"].empty() ? defaultHorizon(tasks) : std::stoll(args["--horizon"]);
+        RtRun run;
+        if (gantt_width || !gantt_range.empty() || !gantt_svg.empty()) {
+            auto feed = [&](GanttView& view) {
+                run = simulatePeriodic(tasks, policy, horizon, [&](int task, long long start, long long len) {
+                    view.add(tasks[task].id, start, len);
+                });
+            };
+            if (!renderGanttView(feed, horizon, gantt_range, gantt_width, gantt_svg)) return 1;
+        } else {
+            run = simulatePeriodic(tasks, policy, horizon);
+        }
+        printRtReport(std::cout, tasks, run);
+        return 0;
+    }
+
+    // Batch mode: every (workload, scheduler) pair on a work-stealing pool,
+    // --scheduler may list several comma-separated defaults.
+    if (!args["--batch"].empty()) {
+        if (!checkpoint_path.empty() || !resume_path.empty()) {
+            std::cerr << "--checkpoint and --resume take a single run, not --batch\n"; return 1;
+        }
+        auto defaults = splitList(scheduler_type);
+        if (defaults.empty()) defaults = kAllSchedulers;
+        unsigned threads = args["--threads"].empty() ? std::thread::hardware_concurrency()
+                                                     : (unsigned)std::stoi(args["--threads"]);
+        return runBatch(args["--batch"], defaults, quantum, smp, threads, output_path);
+    }
 
     // Load processes
-    std::vector<Process> processes;
+    ProcessTable processes;
+    IoWorkload io;
+    GroupTree groups;
     if (random) processes = generateRandomProcesses(num_rand);
-    else if (!input_file.empty()) processes = loadProcesses(input_file);
+    else if (!input_file.empty()) processes = loadProcesses(input_file, &io, &groups);
     else {
         processes = {
             {"P1", 0, 8, 2, 8, 0, 0, 0},
@@ -496,39 +520,159 @@ int main(int argc, char* argv[]) {
     }
     if (processes.empty()) { std::cerr << "No processes loaded.\n"; return 1; }
 
-    // Instantiate chosen scheduler
-    std::unique_ptr<Scheduler> scheduler;
-    if      (scheduler_type == "rr")      scheduler = std::make_unique<RoundRobinScheduler>(quantum);
-    else if (scheduler_type == "fcfs")    scheduler = std::make_unique<FCFSScheduler>();
-    else if (scheduler_type == "sjf")     scheduler = std::make_unique<SJFScheduler>();
-    else if (scheduler_type == "srtf")    scheduler = std::make_unique<SRTFScheduler>();
-    else if (scheduler_type == "priority")scheduler = std::make_unique<PriorityScheduler>();
-    else if (scheduler_type == "mlq")     scheduler = std::make_unique<MLQScheduler>();
-    else if (scheduler_type == "mlfq")    scheduler = std::make_unique<MLFQScheduler>();
-    else if (scheduler_type == "lottery") scheduler = std::make_unique<LotteryScheduler>();
-    else if (scheduler_type == "cfs")     scheduler = std::make_unique<CFSScheduler>();
-    else if (scheduler_type == "edf")     scheduler = std::make_unique<EDFScheduler>();
-    else { std::cerr << "Unknown scheduler: " << scheduler_type << "\n"; return 1; }
+    if (!stats_mode.empty() && stats_mode != "json") { std::cerr << "Unknown stats format: " << stats_mode << "\n"; return 1; }
+    ResultFormat format;
+    if (!parseResultFormat(format_name, format)) { std::cerr << "Unknown format: " << format_name << "\n"; return 1; }
+    // The series, timeline and structured results describe a single CPU track
+    // of processes and idle time, without the CS segments of an overhead run
+    if ((smp.cpus > 1 || smp.overheads()) && (window > 0 || !timeline_path.empty() || format != ResultFormat::Text ||
+                                              gantt_width > 0 || !gantt_svg.empty())) {
+        std::cerr << "--window, --timeline, --format and --gantt-* need a single CPU without overheads\n"; return 1;
+    }
+    if (!io.empty()) {
+        if (window > 0 || !timeline_path.empty()) { std::cerr << "--window and --timeline do not model I/O yet\n"; return 1; }
+        smp.io = &io;
+    }
+    if (!groups.empty()) smp.groups = &groups;
+
+    // Workload edits replayed incrementally against one baseline run
+    if (!args["--whatif"].empty()) {
+        if (smp.cpus > 1 || smp.overheads() || smp.io || smp.groups || smp.predict > 0) {
+            std::cerr << "--whatif needs a single CPU without I/O, groups, overheads or prediction\n"; return 1;
+        }
+        return runWhatIf(args["--whatif"], scheduler_type, quantum, checkpoint_every, processes);
+    }
+
+    // Instantiate chosen scheduler; counters are only compiled in when asked for
+    std::unique_ptr<Scheduler> scheduler = stats_mode.empty() && progress_sec <= 0
+        ? makeScheduler(scheduler_type, quantum, smp)
+        : makeScheduler<SchedCounters<true>>(scheduler_type, quantum, smp);
+    if (!scheduler) { std::cerr << "Unknown scheduler: " << scheduler_type << "\n"; return 1; }
+
+    // Optional heartbeat on stderr or --progress-file
+    std::ofstream progress_file;
+    if (!progress_path.empty()) {
+        progress_file.open(progress_path);
+        if (!progress_file) { std::cerr << "Could not open progress file: " << progress_path << "\n"; return 1; }
+    }
+    std::unique_ptr<Heartbeat> heartbeat;
+    if (progress_sec > 0) {
+        heartbeat = std::make_unique<Heartbeat>(progress_path.empty() ? std::cerr : progress_file,
+                                                progress_sec, processes.size());
+        scheduler->attachHeartbeat(heartbeat.get());
+    }
+
+    // Optional windowed series, written as CSV to stdout or --window-file
+    std::unique_ptr<WindowSeries> series;
+    if (window > 0) {
+        series = std::make_unique<WindowSeries>(window);
+        scheduler->attachSeries(series.get());
+    }
+
+    // Optional Chrome trace timeline, streamed while the run goes
+    std::ofstream timeline_file;
+    std::unique_ptr<TimelineWriter> timeline;
+    if (!timeline_path.empty()) {
+        timeline_file.open(timeline_path);
+        if (!timeline_file) { std::cerr << "Could not open timeline file: " << timeline_path << "\n"; return 1; }
+        timeline = std::make_unique<TimelineWriter>(timeline_file, scheduler_type);
+        scheduler->attachTimeline(timeline.get());
+    }
+
+    // Optional snapshots every --checkpoint-every units, and --resume from one
+    Checkpoints checkpoints;
+    Snapshot resume_from;
+    if (!checkpoint_path.empty() || !resume_path.empty()) {
+        if (!checkpoint_path.empty() && checkpoint_every <= 0) {
+            std::cerr << "--checkpoint needs a positive --checkpoint-every\n"; return 1;
+        }
+        checkpoints.scheduler = scheduler_type;
+        checkpoints.quantum = quantum;
+        checkpoints.interval = checkpoint_path.empty() ? 0 : checkpoint_every;
+        checkpoints.path = checkpoint_path;
+        if (!resume_path.empty()) {
+            std::string error;
+            if (!loadSnapshot(resume_path, resume_from, error)) { std::cerr << error << "\n"; return 1; }
+            checkpoints.resume = &resume_from;
+        }
+        if (!scheduler->attachCheckpoints(&checkpoints)) {
+            std::cerr << "--checkpoint and --resume need a single CPU without I/O, groups, overheads or prediction\n";
+            return 1;
+        }
+    }
 
     // Run simulation
-    std::vector<std::pair<std::string,int>> gantt;
-    int total_time = 0;
+    GanttChart gantt;
+    SimTime total_time = 0;
     scheduler->schedule(processes, gantt, total_time);
-    printResults(processes, total_time, gantt);
+    if (!checkpoints.error.empty()) {
+        std::cerr << "Cannot resume from " << resume_path << ": " << checkpoints.error << "\n"; return 1;
+    }
+    if (heartbeat) {
+        const RunCounters* c = scheduler->counters();
+        heartbeat->finish(total_time, c->completions, c->events());
+    }
+    // Downsampled Gantt view; as text it takes the place of the full chart line
+    bool gantt_text = gantt_width > 0 && gantt_svg.empty();
+    if (gantt_text || !gantt_svg.empty()) {
+        auto feed = [&](GanttView& view) {
+            long long t = 0;
+            for (const auto& e : gantt) { view.add(e.first, t, e.second); t += e.second; }
+        };
+        if (!renderGanttView(feed, total_time, gantt_range, gantt_width, gantt_svg)) return 1;
+    }
+
+    // Several CPUs: one Gantt track per CPU and per-CPU counts replace the chart line
+    const SmpReport* smp_report = scheduler->smp();
+    if (smp_report) {
+        printSmpReport(std::cout, *smp_report, total_time);
+        gantt_text = true;
+    }
+    if (!groups.empty() && format == ResultFormat::Text) {
+        const GanttChart* tracks = smp_report ? smp_report->tracks.data() : &gantt;
+        std::size_t cpus = smp_report ? smp_report->tracks.size() : 1;
+        printGroupReport(std::cout, groups, processes, tracks, cpus, (long long)total_time * smp.cpus);
+    }
+
+    // Results go to stdout, or with an explicit --format to --output
+    const MetricsAccumulator& metrics = scheduler->metrics();
+    bool results_to_file = !format_name.empty() && !output_path.empty();
+    if (results_to_file) {
+        std::ofstream out(output_path, std::ios::binary);
+        if (!out) { std::cerr << "Could not open output file: " << output_path << "\n"; return 1; }
+        writeResults(out, format, processes, gantt, metrics);
+    } else {
+        writeResults(std::cout, format, processes, gantt, metrics, !gantt_text);
+    }
+    if (!stats_mode.empty()) printCountersJson(std::cout, scheduler_type, *scheduler->counters());
+    if (!memory_mode.empty()) printMemoryReport(std::cout, memory_mode == "json", processes, gantt);
+    if (series) {
+        if (window_path.empty()) series->writeCsv(std::cout);
+        else {
+            std::ofstream csv(window_path);
+            if (csv) series->writeCsv(csv);
+            else std::cerr << "Could not open window file: " << window_path << "\n";
+        }
+    }
+    if (!trace_dump.empty()) {
+        if (!traceRing().dump(trace_dump.c_str())) std::cerr << "Could not write trace dump: " << trace_dump << "\n";
+        else {
+            std::ofstream ids(trace_dump, std::ios::app);
+            for (const auto& p : processes) ids << p.id << "\n";
+        }
+    }
 
     // Optional log
-    if (!output_path.empty()) {
+    if (!output_path.empty() && !results_to_file) {
         std::ofstream log(output_path);
         if (log) {
-            double avg_wait, avg_turn, cpu_util, throughput;
-            calculateMetrics(processes, total_time, avg_wait, avg_turn, cpu_util, throughput);
-            log << "Scheduler: " << scheduler_type << "\n";
-            log << "Gantt: "; for (auto& e: gantt) log << e.first << "("<<e.second<<") ";
-            log << "\n";
-            log << "Avg Waiting: " << avg_wait << "\n";
-            log << "Avg Turnaround: " << avg_turn << "\n";
-            log << "CPU Utilization: " << cpu_util << "%\n";
-            log << "Throughput: " << throughput << " processes/unit time\n";
+            OutBuffer b(log);
+            b.put("Scheduler: ").put(scheduler_type).put("\nGantt: ");
+            for (auto& e: gantt) b.put(e.first).put('(').num((long long)e.second).put(") ");
+            b.put("\nAvg Waiting: ").num6(metrics.avgWait())
+             .put("\nAvg Turnaround: ").num6(metrics.avgTurnaround())
+             .put("\nCPU Utilization: ").num6(metrics.cpuUtilization())
+             .put("%\nThroughput: ").num6(metrics.throughput()).put(" processes/unit time\n");
         } else std::cerr << "Could not open output file: " << output_path << "\n";
     }
     return 0;
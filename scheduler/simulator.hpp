@@ -0,0 +1,828 @@
+// simulator.hpp
+// Process model, metrics, the scheduler implementations and workload loading,
+// shared by the simulator CLI and the benchmark harness.
+#pragma once
+#include <climits>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <vector>
+#include <queue>
+#include <algorithm>
+#include <string>
+#include <fstream>
+#include <random>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <numeric>
+#include <tuple>
+#include <sstream>
+
+#include "checkpoint.hpp"
+#include "counters.hpp"
+#include "groups.hpp"
+#include "io.hpp"
+#include "memory.hpp"
+#include "metrics.hpp"
+#include "results.hpp"
+#include "sim_time.hpp"
+
+struct Process {
+    std::string id;
+    SimTime arrival_time;
+    SimTime burst_time;
+    int priority;
+    SimTime remaining_time;
+    SimTime waiting_time = 0;
+    SimTime turnaround_time = 0;
+    SimTime deadline = 0;
+    SimTime start_time = -1;   // first dispatch, -1 until the process has run
+    int program = -1;      // I/O program in the workload's IoWorkload, -1 for one CPU burst
+    int group = -1;        // CFS group in the workload's GroupTree, -1 for the root
+};
+
+using ProcessTable = std::vector<Process, TrackingAllocator<Process, MemTag::ProcessTable>>;
+using GanttChart = std::vector<std::pair<std::string, SimTime>,
+                               TrackingAllocator<std::pair<std::string, SimTime>, MemTag::Gantt>>;
+
+// Orders `procs` by arrival exactly as std::sort, or std::stable_sort with
+// `stable`, would order the table, `tie` breaking equal arrivals. The sort
+// runs over (arrival, row) keys and then moves every row once into place:
+// rows are over 100 bytes with 64-bit times, and sorting them directly took
+// most of a short run.
+template <class Tie = std::nullptr_t>
+void sortByArrival(ProcessTable& procs, bool stable = false, Tie tie = nullptr) {
+    struct Key { SimTime arrival; std::size_t row; };
+    ReadyVector<Key> keys(procs.size());
+    for (std::size_t i = 0; i < procs.size(); ++i) keys[i] = {procs[i].arrival_time, i};
+    auto less = [&](const Key& a, const Key& b) {
+        if constexpr (std::is_same_v<Tie, std::nullptr_t>) return a.arrival < b.arrival;
+        else return a.arrival != b.arrival ? a.arrival < b.arrival : tie(procs[a.row], procs[b.row]);
+    };
+    if (stable) std::stable_sort(keys.begin(), keys.end(), less);
+    else std::sort(keys.begin(), keys.end(), less);
+    // Row i takes keys[i].row; follow each cycle of the permutation once
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+        if (keys[i].row == i) continue;
+        Process held = std::move(procs[i]);
+        std::size_t j = i;
+        while (keys[j].row != i) {
+            std::size_t from = keys[j].row;
+            procs[j] = std::move(procs[from]);
+            keys[j].row = j;
+            j = from;
+        }
+        procs[j] = std::move(held);
+        keys[j].row = j;
+    }
+}
+
+struct SmpReport;
+
+// Snapshots of a run (checkpoint.hpp): one every `interval` units of
+// simulated time, written to `path` and handed to `taken`. With `resume` set
+// a run goes on from that snapshot instead of starting at 0.
+struct Checkpoints {
+    std::string scheduler;          // recorded in snapshots and checked on resume
+    int quantum = 0;
+    long long interval = 0;         // 0: no snapshots
+    std::string path;               // "%t" becomes the time; empty: not written
+    bool full = true;
+    // Gets every snapshot taken; returning true stops the run there.
+    std::function<bool(Snapshot&)> taken;
+    const Snapshot* resume = nullptr;
+    const ProcessTable* base_procs = nullptr;   // final tables a light snapshot is restored against
+    const GanttChart* base_gantt = nullptr;
+    std::string error;              // why the resume failed; the run did not happen
+    bool stopped = false;           // `taken` ended the run early
+    long long next = 0;             // time of the next snapshot
+};
+
+class Scheduler {
+public:
+    virtual ~Scheduler() = default;
+    virtual void schedule(ProcessTable& processes,
+                          GanttChart& gantt,
+                          SimTime& total_time) = 0;
+    // Metrics of the last run, accumulated from its events.
+    virtual const MetricsAccumulator& metrics() const = 0;
+    // Counters of the last run, or nullptr when built without them.
+    virtual const RunCounters* counters() const { return nullptr; }
+    // Periodic progress reports; ignored when built without counters.
+    virtual void attachHeartbeat(Heartbeat*) {}
+    // Windowed series filled by every later run; nullptr detaches.
+    virtual void attachSeries(WindowSeries*) {}
+    // Timeline export written during every later run; nullptr detaches.
+    virtual void attachTimeline(TimelineWriter*) {}
+    // Per-CPU tracks and counts of a multi-CPU run, nullptr for one CPU.
+    virtual const SmpReport* smp() const { return nullptr; }
+    // Snapshots and resume for every later run; false when the scheduler
+    // cannot take them.
+    virtual bool attachCheckpoints(Checkpoints*) { return false; }
+};
+
+// Times schedule() and owns the counters; concrete schedulers implement run()
+// and report their hot-path events through `ctr`, which also feeds the trace
+// ring.
+template <class Counters>
+class CountedScheduler : public Scheduler {
+protected:
+    Counters ctr;
+    MetricsAccumulator acc;
+    WindowSeries* series = nullptr;
+    TimelineWriter* timeline = nullptr;
+    Checkpoints* checkpoints = nullptr;
+    int cpus = 1;
+    virtual void run(ProcessTable& processes,
+                     GanttChart& gantt,
+                     SimTime& total_time) = 0;
+
+    // run() calls resume() once set up, just before its loop, and
+    // checkpoint() at the top of every step. `state` passes the loop's own
+    // variables to the archive it is given, which reads or writes them.
+    // resume() is false when the snapshot does not fit the run, which must
+    // then return; checkpoint() is true when the run should stop there.
+    template <class State> bool resume(ProcessTable& procs, GanttChart& gantt, State&& state) {
+        if (!checkpoints || !checkpoints->resume) return true;
+        Checkpoints& cp = *checkpoints;
+        const Snapshot& s = *cp.resume;
+        auto fail = [&](std::string why) { cp.error = std::move(why); return false; };
+        if (s.scheduler != cp.scheduler || s.quantum != cp.quantum)
+            return fail("Snapshot was taken by " + s.scheduler + " with quantum " + std::to_string(s.quantum));
+        if (s.time_bits != SIM_TIME_BITS)
+            return fail("Snapshot was taken with " + std::to_string(s.time_bits) + "-bit simulated time");
+        if (s.processes != procs.size() || s.ids != hashIds(procs)) return fail("Snapshot is of another workload");
+        if (!s.full && !(cp.base_procs && cp.base_gantt)) return fail("Light snapshot without the run it came from");
+        SnapshotReader core(s.core), history(s.history);
+        if (!readRows(core, history, procs, s.full ? nullptr : cp.base_procs))
+            return fail("Processes the snapshot has already run differ from the workload");
+        if (!readGantt(history, procs, gantt, s.full ? nullptr : cp.base_gantt)) return fail("Bad Gantt chart in snapshot");
+        history(acc);
+        // Counters resumed without a count start from zero; a count resumed
+        // without counters is read past.
+        if (s.counters == Counters::enabled) {
+            ctr.transfer(history, procs.data());
+        } else if (s.counters) {
+            SchedCounters<true> skipped;
+            skipped.transfer(history, procs.data());
+        }
+        state(core);
+        if (!core.done() || !history.done()) return fail("Snapshot does not match the scheduler's state");
+        if (cp.interval > 0) cp.next = (s.time / cp.interval + 1) * cp.interval;
+        return true;
+    }
+    template <class State> bool checkpoint(ProcessTable& procs, GanttChart& gantt, SimTime t, State&& state) {
+        return checkpoints && t >= checkpoints->next && takeSnapshot(procs, gantt, t, state);
+    }
+
+private:
+    template <class State> bool takeSnapshot(ProcessTable& procs, GanttChart& gantt, SimTime t, State& state) {
+        Checkpoints& cp = *checkpoints;
+        Snapshot s;
+        s.scheduler = cp.scheduler;
+        s.quantum = cp.quantum;
+        s.time_bits = SIM_TIME_BITS;
+        s.counters = Counters::enabled;
+        s.full = cp.full;
+        s.processes = procs.size();
+        s.ids = hashIds(procs);
+        s.time = t;
+        SnapshotWriter core, history;
+        writeRows(core, history, procs, cp.full);
+        writeGantt(history, procs, gantt, cp.full);
+        history(acc);
+        ctr.transfer(history, procs.data());
+        state(core);
+        s.core = std::move(core.bytes());
+        s.history = std::move(history.bytes());
+        cp.next = (t / cp.interval + 1) * cp.interval;
+        if (!cp.path.empty() && !saveSnapshot(snapshotPath(cp.path, t), s))
+            std::cerr << "Could not write snapshot: " << snapshotPath(cp.path, t) << "\n";
+        return cp.stopped = cp.taken && cp.taken(s);
+    }
+
+public:
+    void schedule(ProcessTable& processes,
+                  GanttChart& gantt,
+                  SimTime& total_time) final {
+        for (auto& p : processes) p.start_time = -1;
+        if (checkpoints) {
+            checkpoints->next = checkpoints->interval > 0 ? checkpoints->interval : LLONG_MAX;
+            checkpoints->error.clear();
+            checkpoints->stopped = false;
+        }
+        acc.reset();
+        if (series) series->reset();
+        ctr.reset(processes.data(), &acc);
+        if constexpr (Counters::enabled) {
+            auto start = std::chrono::steady_clock::now();
+            run(processes, gantt, total_time);
+            ctr.elapsed(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+        } else {
+            run(processes, gantt, total_time);
+        }
+        acc.finish(total_time, cpus);
+        if (series) series->finish(total_time);
+        if (timeline) timeline->finish(total_time);
+    }
+    const MetricsAccumulator& metrics() const override { return acc; }
+    const RunCounters* counters() const override { return ctr.get(); }
+    void attachHeartbeat(Heartbeat* h) override { ctr.attach(h); }
+    void attachSeries(WindowSeries* s) override { series = s; ctr.attach(s); }
+    void attachTimeline(TimelineWriter* t) override { timeline = t; ctr.attach(t); }
+    bool attachCheckpoints(Checkpoints* c) override { checkpoints = c; return true; }
+};
+
+template <class Counters = SchedCounters<false>>
+class FCFSScheduler : public CountedScheduler<Counters> {
+    using CountedScheduler<Counters>::ctr;
+protected:
+    void run(ProcessTable& procs,
+             GanttChart& gantt,
+             SimTime& total_time) override {
+        sortByArrival(procs);
+        SimTime t = 0;
+        int n = (int)procs.size(), arrived = 0, i = 0;
+        auto state = [&](auto& ar) { ar(t, i, arrived); };
+        if (!this->resume(procs, gantt, state)) return;
+        for (; i < n; ++i) {
+            if (this->checkpoint(procs, gantt, t, state)) return;
+            auto& p = procs[i];
+            if (t < p.arrival_time) { ctr.idle(t); gantt.emplace_back("IDLE", p.arrival_time - t); t = p.arrival_time; }
+            if constexpr (Counters::observed) {
+                for (; arrived < n && procs[arrived].arrival_time <= t; ++arrived)
+                    ctr.enqueue(&procs[arrived], arrived - i + 1, procs[arrived].arrival_time);
+                ctr.dequeue();
+                ctr.dispatch(&p, arrived - i, t);
+            }
+            gantt.emplace_back(p.id, p.burst_time);
+            t += p.burst_time;
+            p.remaining_time  = 0;
+            p.turnaround_time = t - p.arrival_time;
+            p.waiting_time    = p.turnaround_time - p.burst_time;
+            ctr.complete(&p, t);
+        }
+        total_time = t;
+    }
+};
+
+template <class Counters = SchedCounters<false>>
+class SJFScheduler : public CountedScheduler<Counters> {
+    using CountedScheduler<Counters>::ctr;
+protected:
+    void run(ProcessTable& procs,
+             GanttChart& gantt,
+             SimTime& total_time) override {
+        sortByArrival(procs);
+        SimTime t = 0;
+        int n = (int)procs.size(), done = 0, arrived = 0, first_unused = 0;
+        ReadyVector<int> used(n, 0);
+        // Snapshots leave `used` out: it is the finished processes, which a
+        // restored table already marks
+        auto state = [&](auto& ar) { ar(t, done, arrived, first_unused); };
+        if (!this->resume(procs, gantt, state)) return;
+        for (int i = 0; done && i < n; ++i) used[i] = snapshot_detail::settled(procs[i]);
+        while (done < n) {
+            if (this->checkpoint(procs, gantt, t, state)) return;
+            // The table is in arrival order: only rows from the first unused
+            // one to the last arrived one can be ready
+            while (first_unused < n && used[first_unused]) ++first_unused;
+            int idx = -1;
+            size_t depth = 0;
+            for (int i = first_unused; i < n && procs[i].arrival_time <= t; ++i)
+                if (!used[i]) {
+                    ++depth;
+                    if (idx < 0 || procs[i].burst_time < procs[idx].burst_time) idx = i;
+                }
+            if constexpr (Counters::observed)
+                for (; arrived < n && procs[arrived].arrival_time <= t; ++arrived)
+                    ctr.enqueue(&procs[arrived], depth, procs[arrived].arrival_time);
+            if (idx == -1) {
+                // Nothing has arrived: the earliest unused process is next
+                while (used[first_unused]) ++first_unused;
+                SimTime next_arr = procs[first_unused].arrival_time;
+                ctr.idle(t);
+                gantt.emplace_back("IDLE", next_arr - t); t = next_arr; continue;
+            }
+            auto& p = procs[idx];
+            ctr.dequeue();
+            ctr.dispatch(&p, depth, t);
+            gantt.emplace_back(p.id, p.burst_time);
+            t += p.burst_time;
+            p.remaining_time  = 0;
+            p.turnaround_time = t - p.arrival_time;
+            p.waiting_time    = p.turnaround_time - p.burst_time;
+            ctr.complete(&p, t);
+            used[idx] = 1; ++done;
+        }
+        total_time = t;
+    }
+};
+
+template <class Counters = SchedCounters<false>>
+class SRTFScheduler : public CountedScheduler<Counters> {
+    using CountedScheduler<Counters>::ctr;
+protected:
+    void run(ProcessTable& procs,
+             GanttChart& gantt,
+             SimTime& total_time) override {
+        for (auto& p : procs) p.remaining_time = p.burst_time;
+        sortByArrival(procs);
+        SimTime t = 0;
+        int n = (int)procs.size(), finished = 0, arrived = 0, first_live = 0;
+        int last = -1;  // process of the open Gantt segment, -1 while idle
+        SimTime run = 0;
+        auto state = [&](auto& ar) { ar(t, finished, arrived, last, run); };
+        if (!this->resume(procs, gantt, state)) return;
+        auto name = [&](int i) { return i < 0 ? std::string("IDLE") : procs[i].id; };
+        while (finished < n) {
+            if (this->checkpoint(procs, gantt, t, state)) return;
+            // Rows before the first unfinished one and after the last arrived
+            // one cannot run
+            while (first_live < n && procs[first_live].remaining_time == 0) ++first_live;
+            int idx = -1;
+            size_t depth = 0;
+            for (int i = first_live; i < n && procs[i].arrival_time <= t; ++i)
+                if (procs[i].remaining_time > 0) {
+                    ++depth;
+                    if (idx < 0 || procs[i].remaining_time < procs[idx].remaining_time) idx = i;
+                }
+            if constexpr (Counters::observed)
+                for (; arrived < n && procs[arrived].arrival_time <= t; ++arrived)
+                    ctr.enqueue(&procs[arrived], depth, procs[arrived].arrival_time);
+            if (idx == -1) {
+                if (last != -1) { if (run) gantt.emplace_back(name(last), run); last = -1; run = 0; }
+                ctr.idle(t);
+                ++t; ++run; continue;
+            }
+            ctr.dispatch(&procs[idx], depth, t);
+            if (last != idx) { if (run) gantt.emplace_back(name(last), run); last = idx; run = 0; }
+            ++run; --procs[idx].remaining_time; ++t;
+            if (procs[idx].remaining_time == 0) {
+                procs[idx].turnaround_time = t - procs[idx].arrival_time;
+                procs[idx].waiting_time    = procs[idx].turnaround_time - procs[idx].burst_time;
+                ctr.dequeue();
+                ctr.complete(&procs[idx], t);
+                ++finished;
+            }
+        }
+        if (run) gantt.emplace_back(name(last), run);
+        total_time = t;
+    }
+};
+
+template <class Counters = SchedCounters<false>>
+class PriorityScheduler : public CountedScheduler<Counters> {
+    using CountedScheduler<Counters>::ctr;
+protected:
+    void run(ProcessTable& procs,
+             GanttChart& gantt,
+             SimTime& total_time) override {
+        sortByArrival(procs);
+        SimTime t = 0;
+        int n = (int)procs.size(), done = 0, arrived = 0, first_unused = 0;
+        ReadyVector<int> used(n, 0);
+        // Snapshots leave `used` out: it is the finished processes, which a
+        // restored table already marks
+        auto state = [&](auto& ar) { ar(t, done, arrived, first_unused); };
+        if (!this->resume(procs, gantt, state)) return;
+        for (int i = 0; done && i < n; ++i) used[i] = snapshot_detail::settled(procs[i]);
+        while (done < n) {
+            if (this->checkpoint(procs, gantt, t, state)) return;
+            // The table is in arrival order: only rows from the first unused
+            // one to the last arrived one can be ready
+            while (first_unused < n && used[first_unused]) ++first_unused;
+            int idx = -1;
+            size_t depth = 0;
+            for (int i = first_unused; i < n && procs[i].arrival_time <= t; ++i)
+                if (!used[i]) {
+                    ++depth;
+                    if (idx < 0 || procs[i].priority < procs[idx].priority) idx = i;
+                }
+            if constexpr (Counters::observed)
+                for (; arrived < n && procs[arrived].arrival_time <= t; ++arrived)
+                    ctr.enqueue(&procs[arrived], depth, procs[arrived].arrival_time);
+            if (idx == -1) {
+                // Nothing has arrived: the earliest unused process is next
+                while (used[first_unused]) ++first_unused;
+                SimTime next_arr = procs[first_unused].arrival_time;
+                ctr.idle(t);
+                gantt.emplace_back("IDLE", next_arr - t); t = next_arr; continue;
+            }
+            auto& p = procs[idx];
+            ctr.dequeue();
+            ctr.dispatch(&p, depth, t);
+            gantt.emplace_back(p.id, p.burst_time);
+            t += p.burst_time;
+            p.remaining_time  = 0;
+            p.turnaround_time = t - p.arrival_time;
+            p.waiting_time    = p.turnaround_time - p.burst_time;
+            ctr.complete(&p, t);
+            used[idx] = 1; ++done;
+        }
+        total_time = t;
+    }
+};
+
+template <class Counters = SchedCounters<false>>
+class RoundRobinScheduler : public CountedScheduler<Counters> {
+    using CountedScheduler<Counters>::ctr;
+private:
+    int quantum;
+
+public:
+    explicit RoundRobinScheduler(int q) : quantum(q) {}
+
+protected:
+    void run(ProcessTable& processes,
+             GanttChart& gantt,
+             SimTime& total_time) override {
+        // Initialize remaining time
+        for (auto& p : processes) p.remaining_time = p.burst_time;
+
+        // Ensure sorted by arrival for streaming arrivals into ready_queue
+        sortByArrival(processes, true);
+
+        ReadyQueue<int> ready_queue;
+        SimTime current_time = 0;
+        int idx = 0;  // index for processes (arrivals)
+
+        // Helper: add all arrivals up to current_time
+        auto add_arrivals = [&](SimTime t) {
+            while (idx < (int)processes.size() && processes[idx].arrival_time <= t) {
+                ready_queue.push(idx++);
+                ctr.enqueue(&processes[ready_queue.back()], ready_queue.size(), t);
+            }
+        };
+
+        add_arrivals(0);
+
+        int last = -1;  // process of the open Gantt segment
+        SimTime last_start = -1;
+        auto state = [&](auto& ar) { ar(current_time, idx, ready_queue, last, last_start); };
+        if (!this->resume(processes, gantt, state)) return;
+
+        while (!ready_queue.empty() || idx < (int)processes.size()) {
+            if (this->checkpoint(processes, gantt, current_time, state)) return;
+            if (ready_queue.empty()) {
+                // Idle time: advance to next arrival
+                ctr.idle(current_time);
+                if (idx < (int)processes.size()) current_time = processes[idx].arrival_time;
+                add_arrivals(current_time);
+                continue;
+            }
+
+            int ci = ready_queue.front();
+            Process* current = &processes[ci];
+            ctr.dispatch(current, ready_queue.size(), current_time);
+            ready_queue.pop();
+            ctr.dequeue();
+
+            SimTime run_time = std::min<SimTime>(quantum, current->remaining_time);
+            SIM_ASSERT(run_time > 0, "round robin needs a positive quantum");
+
+            // Commit previous segment if context switched
+            if (last != ci) {
+                if (last != -1) {
+                    gantt.emplace_back(processes[last].id, current_time - last_start);
+                }
+                last = ci;
+                last_start = current_time;
+            }
+
+            current->remaining_time -= run_time;
+            current_time += run_time;
+
+            // Add newly arrived during this slice
+            add_arrivals(current_time);
+
+            if (current->remaining_time > 0) {
+                ready_queue.push(ci);
+                ctr.enqueue(current, ready_queue.size(), current_time);
+            } else {
+                current->turnaround_time = current_time - current->arrival_time;
+                current->waiting_time = current->turnaround_time - current->burst_time;
+                ctr.complete(current, current_time);
+            }
+        }
+
+        if (last != -1) {
+            gantt.emplace_back(processes[last].id, current_time - last_start);
+        }
+        total_time = current_time;
+    }
+};
+
+template <class Counters = SchedCounters<false>>
+class MLQScheduler : public CountedScheduler<Counters> {
+    using CountedScheduler<Counters>::ctr;
+protected:
+    void run(ProcessTable& procs,
+             GanttChart& gantt,
+             SimTime& total_time) override {
+        SimTime t = 0;
+        ReadyQueue<int> high, low;
+        for (int i = 0; i < (int)procs.size(); ++i) {
+            if (procs[i].priority < 3) high.push(i); else low.push(i);
+            ctr.enqueue(&procs[i], high.size() + low.size(), 0);
+        }
+        for (auto& p : procs) p.remaining_time = p.burst_time;
+        auto state = [&](auto& ar) { ar(t, high, low); };
+        if (!this->resume(procs, gantt, state)) return;
+        while (!high.empty() || !low.empty()) {
+            if (this->checkpoint(procs, gantt, t, state)) return;
+            size_t depth = high.size() + low.size();
+            ctr.dequeue();
+            if (!high.empty()) {
+                int i = high.front(); high.pop();
+                auto& p = procs[i];
+                ctr.dispatch(&p, depth, t);
+                SimTime slice = std::min<SimTime>(4, p.remaining_time);
+                gantt.emplace_back(p.id, slice);
+                t += slice; p.remaining_time -= slice;
+                if (p.remaining_time > 0) { high.push(i); ctr.enqueue(&p, depth, t); }
+                else { p.turnaround_time = t - p.arrival_time; p.waiting_time = p.turnaround_time - p.burst_time; ctr.complete(&p, t); }
+            } else {
+                int i = low.front(); low.pop();
+                auto& p = procs[i];
+                ctr.dispatch(&p, depth, t);
+                gantt.emplace_back(p.id, p.burst_time);
+                t += p.burst_time;
+                p.remaining_time  = 0;
+                p.turnaround_time = t - p.arrival_time;
+                p.waiting_time    = p.turnaround_time - p.burst_time;
+                ctr.complete(&p, t);
+            }
+        }
+        total_time = t;
+    }
+};
+
+template <class Counters = SchedCounters<false>>
+class MLFQScheduler : public CountedScheduler<Counters> {
+    using CountedScheduler<Counters>::ctr;
+protected:
+    void run(ProcessTable& procs,
+             GanttChart& gantt,
+             SimTime& total_time) override {
+        std::vector<ReadyQueue<int>> qs(3);
+        std::vector<SimTime> quanta = {2,4,8};
+        for (int i = 0; i < (int)procs.size(); ++i) { qs[0].push(i); procs[i].remaining_time = procs[i].burst_time; ctr.enqueue(&procs[i], i + 1, 0); }
+        size_t depth = procs.size();
+        SimTime t = 0;
+        auto state = [&](auto& ar) { ar(t, qs, depth); };
+        if (!this->resume(procs, gantt, state)) return;
+        while (true) {
+            if (this->checkpoint(procs, gantt, t, state)) return;
+            int lvl = -1;
+            for (int l=0;l<3;++l) if (!qs[l].empty()) { lvl = l; break; }
+            if (lvl == -1) break;
+            int i = qs[lvl].front(); qs[lvl].pop();
+            auto& p = procs[i];
+            ctr.dequeue();
+            ctr.dispatch(&p, depth, t);
+            SimTime slice = std::min(quanta[lvl], p.remaining_time);
+            gantt.emplace_back(p.id, slice);
+            p.remaining_time -= slice; t += slice;
+            if (p.remaining_time == 0) {
+                p.turnaround_time = t - p.arrival_time;
+                p.waiting_time    = p.turnaround_time - p.burst_time;
+                ctr.complete(&p, t);
+                --depth;
+            } else {
+                int nl = std::min(2, lvl+1);
+                qs[nl].push(i);
+                ctr.enqueue(&p, depth, t);
+            }
+        }
+        total_time = t;
+    }
+};
+
+template <class Counters = SchedCounters<false>>
+class LotteryScheduler : public CountedScheduler<Counters> {
+    using CountedScheduler<Counters>::ctr;
+protected:
+    void run(ProcessTable& procs,
+             GanttChart& gantt,
+             SimTime& total_time) override {
+        for (auto& p : procs) p.remaining_time = p.burst_time;
+        std::mt19937 gen(42);
+        SimTime t = 0;
+        long long left = 0; for (auto& p : procs) left += p.remaining_time;
+        if constexpr (Counters::observed)
+            for (size_t i = 0; i < procs.size(); ++i) ctr.enqueue(&procs[i], i + 1, 0);
+        auto state = [&](auto& ar) { ar(t, left, gen); };
+        if (!this->resume(procs, gantt, state)) return;
+        while (left > 0) {
+            if (this->checkpoint(procs, gantt, t, state)) return;
+            ReadyVector<int> tickets(procs.size(),0);
+            int total = 0;
+            size_t depth = 0;
+            for (int i=0;i<(int)procs.size();++i) if (procs[i].remaining_time>0) {
+                int tk = std::max(1, 10 / std::max(1, procs[i].priority));
+                tickets[i] = tk; total += tk; ++depth;
+            }
+            std::uniform_int_distribution<int> dist(1,total);
+            int draw = dist(gen), winner=-1, acc=0;
+            for (int i=0;i<(int)procs.size();++i) { if (!tickets[i]) continue; acc+=tickets[i]; if (draw<=acc){ winner=i; break; } }
+            SIM_ASSERT(winner >= 0, "lottery draw matched no ticket");
+            auto& p = procs[winner];
+            ctr.dispatch(&p, depth, t);
+            SimTime slice = std::min<SimTime>(2, p.remaining_time);
+            gantt.emplace_back(p.id, slice);
+            p.remaining_time -= slice; t += slice; left -= slice;
+            if (p.remaining_time == 0) {
+                p.turnaround_time = t - p.arrival_time;
+                p.waiting_time    = p.turnaround_time - p.burst_time;
+                ctr.dequeue();
+                ctr.complete(&p, t);
+            }
+        }
+        total_time = t;
+    }
+};
+
+template <class Counters = SchedCounters<false>>
+class CFSScheduler : public CountedScheduler<Counters> {
+    using CountedScheduler<Counters>::ctr;
+    struct CProc { int idx; double vruntime=0.0; auto fields() { return std::tie(idx, vruntime); } };
+    struct Cmp { bool operator()(const CProc& a, const CProc& b) const { return a.vruntime > b.vruntime; } };
+protected:
+    void run(ProcessTable& procs,
+             GanttChart& gantt,
+             SimTime& total_time) override {
+        for (auto& p : procs) p.remaining_time = p.burst_time;
+        ReadyHeap<CProc,Cmp> pq;
+        for (int i=0;i<(int)procs.size();++i) { pq.push({i,0.0}); ctr.enqueue(&procs[i], pq.size(), 0); }
+        SimTime t = 0;
+        auto weight = [&](int pr){ return 1.0 / std::max(1, pr); };
+        auto state = [&](auto& ar) { ar(t, pq); };
+        if (!this->resume(procs, gantt, state)) return;
+        while (!pq.empty()) {
+            if (this->checkpoint(procs, gantt, t, state)) return;
+            auto cp = pq.top(); pq.pop();
+            ctr.dequeue();
+            int i = cp.idx; auto& p = procs[i];
+            if (p.remaining_time==0) continue;
+            ctr.dispatch(&p, pq.size() + 1, t);
+            SimTime slice = std::min<SimTime>(2, p.remaining_time);
+            gantt.emplace_back(p.id, slice);
+            p.remaining_time -= slice; t += slice;
+            cp.vruntime += slice / weight(p.priority);
+            if (p.remaining_time > 0) { pq.push(cp); ctr.enqueue(&p, pq.size(), t); }
+            else { p.turnaround_time = t - p.arrival_time; p.waiting_time = p.turnaround_time - p.burst_time; ctr.complete(&p, t); }
+        }
+        total_time = t;
+    }
+};
+
+template <class Counters = SchedCounters<false>>
+class EDFScheduler : public CountedScheduler<Counters> {
+    using CountedScheduler<Counters>::ctr;
+protected:
+    void run(ProcessTable& procs,
+             GanttChart& gantt,
+             SimTime& total_time) override {
+        for (auto& p : procs) { p.remaining_time = p.burst_time; if (p.deadline==0) p.deadline = p.arrival_time + 2*p.burst_time; }
+        sortByArrival(procs, false, [](const Process& a, const Process& b) { return a.id < b.id; });
+        using Key = std::tuple<SimTime,SimTime,int>; // (deadline, arrival, index)
+        struct Cmp { bool operator()(const Key& x, const Key& y) const { return x > y; } };
+        ReadyHeap<Key,Cmp> pq;
+        int n = (int)procs.size(), finished = 0, ap = 0;
+        SimTime t = 0;
+        auto push_arrivals_up_to = [&](SimTime time){
+            while (ap < n && procs[ap].arrival_time <= time) {
+                if (procs[ap].remaining_time > 0) { pq.emplace(procs[ap].deadline, procs[ap].arrival_time, ap); ctr.enqueue(&procs[ap], pq.size(), time); }
+                ++ap;
+            }
+        };
+        if (ap < n && procs[ap].arrival_time > 0) { ctr.idle(t); gantt.emplace_back("IDLE", procs[ap].arrival_time - t); t = procs[ap].arrival_time; }
+        push_arrivals_up_to(t);
+
+        int last = -1;  // process of the open Gantt segment, -1 while idle
+        SimTime run = 0;
+        auto state = [&](auto& ar) { ar(t, finished, ap, pq, last, run); };
+        if (!this->resume(procs, gantt, state)) return;
+        auto name = [&](int i) { return i < 0 ? std::string("IDLE") : procs[i].id; };
+
+        while (finished < n) {
+            if (this->checkpoint(procs, gantt, t, state)) return;
+            if (pq.empty()) {
+                if (ap < n) {
+                    SimTime next_t = procs[ap].arrival_time;
+                    if (last != -1) { if (run) gantt.emplace_back(name(last), run); last = -1; run = 0; }
+                    ctr.idle(t);
+                    gantt.emplace_back("IDLE", next_t - t);
+                    t = next_t;
+                    push_arrivals_up_to(t);
+                    continue;
+                } else break;
+            }
+            auto [dl, arr, i] = pq.top(); pq.pop();
+            ctr.dequeue();
+            ctr.dispatch(&procs[i], pq.size() + 1, t);
+            if (last != i) { if (run) gantt.emplace_back(name(last), run); last = i; run = 0; }
+            // run 1 unit
+            --procs[i].remaining_time; ++run; ++t;
+            push_arrivals_up_to(t);
+            if (procs[i].remaining_time == 0) {
+                procs[i].turnaround_time = t - procs[i].arrival_time;
+                procs[i].waiting_time    = procs[i].turnaround_time - procs[i].burst_time;
+                ctr.complete(&procs[i], t);
+                ++finished;
+            } else {
+                pq.emplace(procs[i].deadline, procs[i].arrival_time, i);
+                ctr.enqueue(&procs[i], pq.size(), t);
+            }
+        }
+        if (run) gantt.emplace_back(name(last), run);
+        total_time = t;
+    }
+};
+
+// One process per line: ID arrival burst priority [deadline] [I/O program]
+// [group=PATH], plus "device" lines when `io` is given (see io.hpp) and
+// "group" lines when `groups` is (see groups.hpp).
+ProcessTable loadProcesses(const std::string& filename, IoWorkload* io, GroupTree* groups = nullptr) {
+    ProcessTable procs;
+    std::ifstream file(filename);
+    if (!file) { std::cerr << "Error opening file: " << filename << "\n"; return procs; }
+    std::string line, id, extra;
+    SimTime at, bt, dl;
+    int pri;
+    while (std::getline(file, line)) {
+        std::istringstream in(line);
+        if (!(in >> id) || id[0] == '#') continue;
+        if (id == "device") {
+            if (!io || !io->declare(in)) std::cerr << "Ignoring device line: " << line << "\n";
+            continue;
+        }
+        if (id == "group") {
+            if (!groups || !groups->declare(in)) std::cerr << "Ignoring group line: " << line << "\n";
+            continue;
+        }
+        if (!(in >> at >> bt >> pri)) {
+            // Also where a time does not fit in SimTime
+            std::cerr << "Stopping at bad process line: " << line << "\n";
+            break;
+        }
+        dl = 0;
+        int program = -1, group = -1;
+        // Optional deadline, program and group
+        while (in >> extra) {
+            if (extra.compare(0, 6, "group=") == 0) {
+                if (groups && extra.size() > 6) group = groups->find(extra.substr(6));
+                continue;
+            }
+            if (extra.find(':') == std::string::npos) { dl = (SimTime)std::atoll(extra.c_str()); continue; }
+            if (!io) continue;
+            long long cpu = bt;
+            program = io->addProgram(extra, cpu);
+            bt = (SimTime)std::min<long long>(cpu, kMaxSimTime);
+            if (program < 0) std::cerr << "Ignoring I/O program of " << id << ": " << extra << "\n";
+        }
+        procs.push_back({id, at, bt, pri, bt, 0, 0, dl});
+        procs.back().program = program;
+        procs.back().group = group;
+    }
+    sortByArrival(procs);
+    return procs;
+}
+
+ProcessTable loadProcesses(const std::string& filename) { return loadProcesses(filename, nullptr); }
+
+ProcessTable generateRandomProcesses(int num) {
+    ProcessTable procs;
+    procs.reserve(num);
+    std::mt19937 gen((unsigned)std::chrono::system_clock::now().time_since_epoch().count());
+    std::uniform_int_distribution<int> A(0, 20), B(1, 10), P(1, 5);
+    for (int i=0;i<num;++i) {
+        std::string id = "P" + std::to_string(i+1);
+        int at = A(gen), bt = B(gen), pri = P(gen);
+        procs.push_back({id, at, bt, pri, bt, 0, 0, 0});
+    }
+    sortByArrival(procs);
+    return procs;
+}
+
+template <class Counters = SchedCounters<false>>
+std::unique_ptr<Scheduler> makeScheduler(const std::string& type, int quantum) {
+    if      (type == "rr")      return std::make_unique<RoundRobinScheduler<Counters>>(quantum);
+    else if (type == "fcfs")    return std::make_unique<FCFSScheduler<Counters>>();
+    else if (type == "sjf")     return std::make_unique<SJFScheduler<Counters>>();
+    else if (type == "srtf")    return std::make_unique<SRTFScheduler<Counters>>();
+    else if (type == "priority")return std::make_unique<PriorityScheduler<Counters>>();
+    else if (type == "mlq")     return std::make_unique<MLQScheduler<Counters>>();
+    else if (type == "mlfq")    return std::make_unique<MLFQScheduler<Counters>>();
+    else if (type == "lottery") return std::make_unique<LotteryScheduler<Counters>>();
+    else if (type == "cfs")     return std::make_unique<CFSScheduler<Counters>>();
+    else if (type == "edf")     return std::make_unique<EDFScheduler<Counters>>();
+    return nullptr;
+}
+
+const std::vector<std::string> kAllSchedulers = {
+    "fcfs", "sjf", "srtf", "priority", "rr", "mlq", "mlfq", "lottery", "cfs", "edf"
+};
@@ -0,0 +1,883 @@
+// smp.hpp
+// Multi-CPU simulation. Every CPU owns a runqueue of the chosen policy;
+// arriving processes are placed on the least loaded CPU and a balancer either
+// lets idle CPUs steal from the longest queue or periodically migrates work
+// from the longest queue to the shortest. The engine is event driven: time
+// jumps to the next arrival, slice end or balancing tick, and every decision
+// is taken in CPU order so a run is reproducible.
+//
+// Optionally a dispatch costs time before the process runs: a fixed switch
+// cost when the CPU last ran another process, plus a cache warm-up for a
+// process coming back after others ran. The warm-up grows with the time the
+// process was away, as W * (1 - exp(-away / decay)), and is W in full on a
+// CPU it did not last run on. That time shows as "CS" in the Gantt tracks and
+// counts as lost, not busy, CPU time.
+//
+// With --predict, SJF and SRTF order by predicted bursts (predict.hpp)
+// instead of the true ones; SRTF's remaining time is then the estimate less
+// what the burst has run so far.
+//
+// Processes with I/O phases (io.hpp) leave their CPU when a CPU burst ends
+// and queue on the device; when the request completes they are placed again
+// like an arrival. Time blocked on I/O is not waiting time. For them
+// remaining_time is what is left of the current CPU burst, which is what
+// SRTF and the preemption checks compare.
+//
+// With several host threads the engine runs conservatively in windows:
+// after each step it works out how far every CPU can go without another
+// CPU's state mattering (the next arrival, migration pass or possible
+// steal), lets partitions of CPUs play their own slice ends up to there in
+// parallel, and replays their hooks in sequential order. The schedule is
+// the one the sequential engine produces.
+//
+// The policies follow their single-CPU counterparts in simulator.hpp, with
+// one difference: MLQ, MLFQ, Lottery and CFS admit processes at their arrival
+// time instead of queueing every process at time 0.
+#pragma once
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+#include "predict.hpp"
+#include "simulator.hpp"
+
+struct SmpOptions {
+    enum class Balance { Steal, Migrate };
+    int cpus = 1;
+    Balance balance = Balance::Steal;
+    int interval = 50;          // time between migration passes
+    int threads = 1;            // host threads for the windowed engine
+    int switch_cost = 0;        // charged when a CPU changes process
+    int warmup = 0;             // cache warm-up of a process coming back cold
+    int warmup_decay = 100;     // time away after which the cache is ~63% cold
+    bool costed = false;        // overheads modelled even at zero cost, so a sweep stays on one engine
+    const IoWorkload* io = nullptr;   // devices and phases when the workload does I/O
+    const GroupTree* groups = nullptr; // CFS groups when the workload defines them
+    double predict = 0;         // alpha of the SJF/SRTF burst predictor, 0: true bursts
+    double predict_initial = 10; // estimate before any burst was seen
+
+    // Overheads, I/O and burst prediction are only modelled by the event engine.
+    bool overheads() const { return costed || switch_cost > 0 || warmup > 0; }
+};
+
+struct SmpCpuStats {
+    long long busy = 0;
+    std::uint64_t dispatches = 0;
+    std::uint64_t migrations_in = 0;   // processes the balancer moved here
+    std::uint64_t migrations_out = 0;  // processes the balancer moved away
+    long long overhead = 0;            // switch and warm-up time
+};
+
+struct SmpReport {
+    std::vector<GanttChart> tracks;    // one Gantt chart per CPU
+    std::vector<SmpCpuStats> cpus;
+    std::vector<std::string> device_names;
+    std::vector<IoDeviceStats> devices;
+    long long io_overlap = 0;          // time some CPU and some device were both busy
+    PredictionStats prediction;        // SJF/SRTF with --predict
+};
+
+// Per-process policy state that has to follow a process between CPUs.
+struct SmpTaskState {
+    ReadyVector<double> vruntime;
+    ReadyVector<int> level;
+    // When predicting: the estimate and the true length of the current
+    // burst, so SRTF knows how long it has run.
+    ReadyVector<SimTime> predicted, burst;
+};
+
+// One CPU's ready processes under one policy; processes are indices into
+// the table being scheduled.
+class RunQueue {
+public:
+    virtual ~RunQueue() = default;
+    virtual void push(int i) = 0;
+    // Next process to run, -1 when empty.
+    virtual int pop() = 0;
+    virtual std::size_t size() const = 0;
+    // Longest the policy lets `i` run before deciding again.
+    virtual SimTime slice(int i) const = 0;
+    // Preemptive policies: the process pop() would return, else -1.
+    virtual int peek() const { return -1; }
+    // Whether `incoming` should take the CPU from `running`, which has
+    // `left` units of burst left.
+    virtual bool preempts(int, int, SimTime) const { return false; }
+    // `i` ran for `amount` without finishing.
+    virtual void ran(int, SimTime) {}
+};
+
+namespace smp_detail {
+
+class FifoQueue : public RunQueue {
+    ReadyQueue<int> q;
+    const ProcessTable& procs;
+    int quantum;   // 0: run to completion
+public:
+    FifoQueue(const ProcessTable& p, int q_) : procs(p), quantum(q_) {}
+    void push(int i) override { q.push(i); }
+    int pop() override { if (q.empty()) return -1; int i = q.front(); q.pop(); return i; }
+    std::size_t size() const override { return q.size(); }
+    SimTime slice(int i) const override { return quantum > 0 ? quantum : procs[i].remaining_time; }
+};
+
+// Ordered by a key fixed at push time; ties go to the earlier arrival, then
+// the lower index. The predicted keys read the estimates in `st`.
+class KeyedQueue : public RunQueue {
+public:
+    enum class Key { Burst, Remaining, Priority, Deadline, Predicted, PredictedRemaining };
+private:
+    using Entry = std::tuple<SimTime, SimTime, int>;
+    struct Cmp { bool operator()(const Entry& a, const Entry& b) const { return a > b; } };
+    ReadyHeap<Entry, Cmp> heap;
+    const ProcessTable& procs;
+    const SmpTaskState* st;
+    Key key;
+    bool preemptive;
+    SimTime keyOf(int i, SimTime left) const {
+        switch (key) {
+            case Key::Burst:     return procs[i].burst_time;
+            case Key::Remaining: return left;
+            case Key::Priority:  return procs[i].priority;
+            case Key::Deadline:  return procs[i].deadline;
+            case Key::Predicted: return st->predicted[i];
+            case Key::PredictedRemaining: return std::max<SimTime>(0, st->predicted[i] - (st->burst[i] - left));
+        }
+        return 0;
+    }
+public:
+    KeyedQueue(const ProcessTable& p, Key k, bool preempt, const SmpTaskState* s = nullptr)
+        : procs(p), st(s), key(k), preemptive(preempt) {}
+    void push(int i) override { heap.emplace(keyOf(i, procs[i].remaining_time), procs[i].arrival_time, i); }
+    int pop() override { if (heap.empty()) return -1; int i = std::get<2>(heap.top()); heap.pop(); return i; }
+    std::size_t size() const override { return heap.size(); }
+    SimTime slice(int i) const override { return procs[i].remaining_time; }
+    int peek() const override { return preemptive && !heap.empty() ? std::get<2>(heap.top()) : -1; }
+    bool preempts(int incoming, int running, SimTime left) const override {
+        return std::make_tuple(keyOf(incoming, procs[incoming].remaining_time), procs[incoming].arrival_time, incoming) <
+               std::make_tuple(keyOf(running, left), procs[running].arrival_time, running);
+    }
+};
+
+// Priorities below 3 go round robin with a quantum of 4, the rest FCFS.
+class MlqQueue : public RunQueue {
+    ReadyQueue<int> high, low;
+    const ProcessTable& procs;
+public:
+    explicit MlqQueue(const ProcessTable& p) : procs(p) {}
+    void push(int i) override { (procs[i].priority < 3 ? high : low).push(i); }
+    int pop() override {
+        ReadyQueue<int>& q = !high.empty() ? high : low;
+        if (q.empty()) return -1;
+        int i = q.front(); q.pop(); return i;
+    }
+    std::size_t size() const override { return high.size() + low.size(); }
+    SimTime slice(int i) const override { return procs[i].priority < 3 ? 4 : procs[i].remaining_time; }
+};
+
+// Three levels with quanta 2, 4 and 8; a process that uses its whole slice
+// drops a level.
+class MlfqQueue : public RunQueue {
+    ReadyQueue<int> qs[3];
+    SmpTaskState& st;
+public:
+    explicit MlfqQueue(SmpTaskState& s) : st(s) {}
+    void push(int i) override { qs[st.level[i]].push(i); }
+    int pop() override {
+        for (auto& q : qs) if (!q.empty()) { int i = q.front(); q.pop(); return i; }
+        return -1;
+    }
+    std::size_t size() const override { return qs[0].size() + qs[1].size() + qs[2].size(); }
+    SimTime slice(int i) const override { return 2 << st.level[i]; }
+    void ran(int i, SimTime) override { st.level[i] = std::min(2, st.level[i] + 1); }
+};
+
+// max(1, 10 / priority) tickets each, slices of 2, one generator per CPU.
+class LotteryQueue : public RunQueue {
+    ReadyVector<int> members;
+    const ProcessTable& procs;
+    std::mt19937 gen;
+    int total = 0;
+    int tickets(int i) const { return std::max(1, 10 / std::max(1, procs[i].priority)); }
+public:
+    LotteryQueue(const ProcessTable& p, unsigned seed) : procs(p), gen(seed) {}
+    void push(int i) override { members.push_back(i); total += tickets(i); }
+    int pop() override {
+        if (members.empty()) return -1;
+        int draw = std::uniform_int_distribution<int>(1, total)(gen), acc = 0;
+        for (std::size_t k = 0; k < members.size(); ++k) {
+            acc += tickets(members[k]);
+            if (draw <= acc) {
+                int i = members[k];
+                members[k] = members.back();
+                members.pop_back();
+                total -= tickets(i);
+                return i;
+            }
+        }
+        SIM_ASSERT(false, "lottery draw matched no ticket");
+        return -1;
+    }
+    std::size_t size() const override { return members.size(); }
+    SimTime slice(int) const override { return 2; }
+};
+
+// Lowest virtual runtime first, slices of 2; a process joining a queue
+// starts no lower than the queue's minimum so it cannot starve the others.
+class CfsQueue : public RunQueue {
+    using Entry = std::pair<double, int>;
+    struct Cmp { bool operator()(const Entry& a, const Entry& b) const { return a > b; } };
+    ReadyHeap<Entry, Cmp> heap;
+    const ProcessTable& procs;
+    SmpTaskState& st;
+    double min_vruntime = 0;
+public:
+    CfsQueue(const ProcessTable& p, SmpTaskState& s) : procs(p), st(s) {}
+    void push(int i) override {
+        st.vruntime[i] = std::max(st.vruntime[i], min_vruntime);
+        heap.emplace(st.vruntime[i], i);
+    }
+    int pop() override {
+        if (heap.empty()) return -1;
+        auto [v, i] = heap.top();
+        heap.pop();
+        min_vruntime = std::max(min_vruntime, v);
+        return i;
+    }
+    std::size_t size() const override { return heap.size(); }
+    SimTime slice(int) const override { return 2; }
+    void ran(int i, SimTime amount) override { st.vruntime[i] += (double)amount * std::max(1, procs[i].priority); }
+};
+
+// CFS over a group hierarchy with one runqueue per group on this CPU, as in
+// Linux group scheduling. A group is an entity in its parent's queue while
+// any of its processes are queued, and its virtual runtime advances by its
+// processes' CPU time scaled by 1024 / weight, so siblings share their
+// parent's time by weight whatever their process counts. Picking descends
+// from the root through the lowest-vruntime entities: O(depth * log n).
+class GroupCfsQueue : public RunQueue {
+    using Entry = std::pair<double, int>;    // (vruntime, process or ~group)
+    struct Level {
+        ReadySet<Entry> q;
+        double vruntime = 0;                 // of the group's own entity
+        double min_vruntime = 0;
+        bool queued = false;                 // entity is in the parent's queue
+    };
+    const ProcessTable& procs;
+    SmpTaskState& st;
+    const GroupTree& tree;
+    std::vector<Level> levels;
+    std::size_t count = 0;
+
+    int groupOf(int i) const { return procs[i].group < 0 ? 0 : procs[i].group; }
+
+public:
+    GroupCfsQueue(const ProcessTable& p, SmpTaskState& s, const GroupTree& t)
+        : procs(p), st(s), tree(t), levels(t.size()) {}
+
+    void push(int i) override {
+        int g = groupOf(i);
+        st.vruntime[i] = std::max(st.vruntime[i], levels[g].min_vruntime);
+        levels[g].q.emplace(st.vruntime[i], i);
+        ++count;
+        for (; g > 0 && !levels[g].queued; g = tree[g].parent) {
+            Level& l = levels[g];
+            Level& up = levels[tree[g].parent];
+            l.vruntime = std::max(l.vruntime, up.min_vruntime);
+            up.q.emplace(l.vruntime, ~g);
+            l.queued = true;
+        }
+    }
+    int pop() override {
+        if (count == 0) return -1;
+        for (int g = 0;;) {
+            Level& l = levels[g];
+            auto [v, e] = *l.q.begin();
+            l.min_vruntime = std::max(l.min_vruntime, v);
+            if (e < 0) { g = ~e; continue; }
+            l.q.erase(l.q.begin());
+            --count;
+            // Groups left without queued processes leave their parents.
+            for (; g > 0 && levels[g].q.empty(); g = tree[g].parent) {
+                levels[tree[g].parent].q.erase({levels[g].vruntime, ~g});
+                levels[g].queued = false;
+            }
+            return e;
+        }
+    }
+    std::size_t size() const override { return count; }
+    SimTime slice(int) const override { return 2; }
+    void ran(int i, SimTime amount) override {
+        st.vruntime[i] += (double)amount * std::max(1, procs[i].priority);
+        for (int g = groupOf(i); g > 0; g = tree[g].parent) {
+            Level& l = levels[g];
+            double v = l.vruntime + (double)amount * GroupTree::kDefaultWeight / tree[g].weight;
+            if (l.queued) {
+                auto& up = levels[tree[g].parent].q;
+                up.erase({l.vruntime, ~g});
+                up.emplace(v, ~g);
+            }
+            l.vruntime = v;
+        }
+    }
+};
+
+inline std::unique_ptr<RunQueue> makeRunQueue(const std::string& policy, int quantum, int cpu,
+                                              const ProcessTable& procs, SmpTaskState& st,
+                                              const GroupTree* groups = nullptr) {
+    using K = KeyedQueue::Key;
+    bool predicting = !st.predicted.empty();
+    if (policy == "fcfs")     return std::make_unique<FifoQueue>(procs, 0);
+    if (policy == "rr")       return std::make_unique<FifoQueue>(procs, quantum);
+    if (policy == "sjf" && predicting)  return std::make_unique<KeyedQueue>(procs, K::Predicted, false, &st);
+    if (policy == "srtf" && predicting) return std::make_unique<KeyedQueue>(procs, K::PredictedRemaining, true, &st);
+    if (policy == "sjf")      return std::make_unique<KeyedQueue>(procs, K::Burst, false);
+    if (policy == "srtf")     return std::make_unique<KeyedQueue>(procs, K::Remaining, true);
+    if (policy == "priority") return std::make_unique<KeyedQueue>(procs, K::Priority, false);
+    if (policy == "edf")      return std::make_unique<KeyedQueue>(procs, K::Deadline, true);
+    if (policy == "mlq")      return std::make_unique<MlqQueue>(procs);
+    if (policy == "mlfq")     return std::make_unique<MlfqQueue>(st);
+    if (policy == "lottery")  return std::make_unique<LotteryQueue>(procs, 42u + (unsigned)cpu);
+    if (policy == "cfs" && groups && !groups->empty()) return std::make_unique<GroupCfsQueue>(procs, st, *groups);
+    if (policy == "cfs")      return std::make_unique<CfsQueue>(procs, st);
+    return nullptr;
+}
+
+} // namespace smp_detail
+
+// Host threads that run one job per CPU partition and wait for all of them.
+// Created once per run and reused by every window.
+class WindowWorkers {
+    std::vector<std::thread> threads;
+    std::mutex m;
+    std::condition_variable wake, drained;
+    std::function<void(int)> job;
+    std::uint64_t generation = 0;
+    std::size_t pending = 0;
+    bool quit = false;
+
+public:
+    explicit WindowWorkers(int parts) {
+        for (int w = 1; w < parts; ++w)
+            threads.emplace_back([this, w] {
+                std::uint64_t seen = 0;
+                for (;;) {
+                    std::unique_lock<std::mutex> lock(m);
+                    wake.wait(lock, [&] { return quit || generation != seen; });
+                    if (quit) return;
+                    seen = generation;
+                    lock.unlock();
+                    job(w);
+                    lock.lock();
+                    if (--pending == 0) drained.notify_one();
+                }
+            });
+    }
+    ~WindowWorkers() {
+        { std::lock_guard<std::mutex> lock(m); quit = true; }
+        wake.notify_all();
+        for (auto& th : threads) th.join();
+    }
+    int size() const { return (int)threads.size() + 1; }
+
+    // Runs f(0) on the calling thread and f(1) .. f(size() - 1) on the workers.
+    void run(std::function<void(int)> f) {
+        {
+            std::lock_guard<std::mutex> lock(m);
+            job = std::move(f);
+            pending = threads.size();
+            ++generation;
+        }
+        wake.notify_all();
+        job(0);
+        std::unique_lock<std::mutex> lock(m);
+        drained.wait(lock, [&] { return pending == 0; });
+    }
+};
+
+template <class Counters = SchedCounters<false>>
+class SmpScheduler : public CountedScheduler<Counters> {
+    using CountedScheduler<Counters>::ctr;
+    using CountedScheduler<Counters>::cpus;
+    std::string policy;
+    int quantum;
+    SmpOptions opt;
+    SmpReport report;
+
+    struct Cpu {
+        std::unique_ptr<RunQueue> rq;
+        int running = -1;
+        int last = -1;                  // process that ran here most recently
+        long long dispatched = 0;       // current slice: overhead from here,
+        long long start = 0, end = 0;   // the process from start to end
+        long long work = 0;             // CPU time left of everything placed here, as of `start`
+    };
+
+    // A hook a window deferred. Sorting by (time, phase, CPU) gives the
+    // order the sequential engine calls them in.
+    struct Deferred {
+        enum Phase { Complete, Requeue, Dispatch };
+        long long t;
+        int phase, cpu, proc;
+        std::size_t depth;
+        bool operator<(const Deferred& o) const {
+            return std::tie(t, phase, cpu) < std::tie(o.t, o.phase, o.cpu);
+        }
+    };
+
+    ProcessTable* table = nullptr;
+    std::vector<Cpu> cpu;
+    std::vector<long long> left_at;            // when each process last left a CPU, -1 before
+    std::vector<int> last_cpu;
+    std::vector<std::unique_ptr<PhaseGenerator>> gens;   // phases of processes with I/O, while active
+    std::vector<long long> blocked, blocked_since;
+    std::vector<IoDeviceQueue> devs;
+    SmpTaskState st;
+    std::unique_ptr<BurstPredictor> predictor;
+    std::vector<long long> covered;
+    std::vector<std::vector<Deferred>> logs;   // one per partition
+    std::vector<int> finished;                 // completions per partition
+    std::vector<Deferred> merged;
+
+    // Appends [from, to) of `id` to a CPU's chart, filling gaps with IDLE
+    // and merging with the previous segment of the same process.
+    static void emit(GanttChart& track, long long& covered, const std::string& id, long long from, long long to) {
+        if (to <= from) return;
+        if (from > covered) {
+            if (!track.empty() && track.back().first == "IDLE") track.back().second += (SimTime)(from - covered);
+            else track.emplace_back("IDLE", (SimTime)(from - covered));
+        }
+        if (!track.empty() && track.back().first == id) track.back().second += (SimTime)(to - from);
+        else track.emplace_back(id, (SimTime)(to - from));
+        covered = to;
+    }
+
+    std::size_t load(int c) const { return cpu[c].rq->size() + (cpu[c].running >= 0); }
+
+    // Switch and warm-up time before `i` runs on c at t.
+    int overhead(int c, int i, long long t) const {
+        const Cpu& k = cpu[c];
+        if (k.last == i) return 0;
+        int cost = k.last >= 0 ? opt.switch_cost : 0;
+        if (opt.warmup > 0 && left_at[i] >= 0) {
+            if (last_cpu[i] != c || opt.warmup_decay <= 0) cost += opt.warmup;
+            else cost += (int)std::lround(opt.warmup * -std::expm1(-(double)(t - left_at[i]) / opt.warmup_decay));
+        }
+        return cost;
+    }
+
+    // i starts a CPU burst of remaining_time units: estimate it.
+    void predictBurst(int i) {
+        if (!predictor) return;
+        st.burst[i] = (*table)[i].remaining_time;
+        st.predicted[i] = (SimTime)std::llround(predictor->estimate(i));
+    }
+
+    // Process time of c's slice up to t; nothing while still in overhead.
+    SimTime ranFor(int c, long long t) const { return (SimTime)std::max(0LL, t - cpu[c].start); }
+
+    enum class SliceEnd { Ready, Finished, Blocked };
+
+    // Takes c's process off the CPU at t.
+    SliceEnd endSlice(int c, long long t) {
+        Cpu& k = cpu[c];
+        int i = k.running;
+        Process& p = (*table)[i];
+        SimTime amount = ranFor(c, t);
+        p.remaining_time -= amount;
+        k.work -= amount;
+        report.cpus[c].busy += amount;
+        report.cpus[c].overhead += std::min(t, k.start) - k.dispatched;
+        emit(report.tracks[c], covered[c], "CS", k.dispatched, std::min(t, k.start));
+        emit(report.tracks[c], covered[c], p.id, k.start, t);
+        left_at[i] = t;
+        last_cpu[i] = c;
+        k.running = -1;
+        if (p.remaining_time > 0) return SliceEnd::Ready;
+        if (predictor) predictor->observe(i, st.burst[i], st.predicted[i]);
+        PhaseGenerator* g = opt.io ? gens[i].get() : nullptr;
+        if (!g || g->phase().device < 0) {
+            if (g) {
+                p.burst_time = (SimTime)std::min<long long>(g->total(), kMaxSimTime);
+                gens[i].reset();
+            }
+            p.turnaround_time = (SimTime)t - p.arrival_time;
+            p.waiting_time = p.turnaround_time - p.burst_time - (opt.io ? (SimTime)blocked[i] : 0);
+            return SliceEnd::Finished;
+        }
+        // End of a CPU burst: on to the device, with the next burst ready.
+        const IoPhase& ph = g->phase();
+        devs[ph.device].submit(i, ph.service, ph.track, t);
+        blocked_since[i] = t;
+        bool more = g->advance();
+        SIM_ASSERT(more, "I/O request must be followed by a CPU burst");
+        p.remaining_time = g->phase().cpu;
+        predictBurst(i);
+        return SliceEnd::Blocked;
+    }
+
+    void startSlice(int c, int i, long long t) {
+        Cpu& k = cpu[c];
+        SimTime len = std::min(k.rq->slice(i), (*table)[i].remaining_time);
+        SIM_ASSERT(len > 0, "smp slice must be positive");
+        k.dispatched = t;
+        k.start = t + (opt.overheads() ? overhead(c, i, t) : 0);
+        k.end = k.start + len;
+        k.running = i;
+        k.last = i;
+        ++report.cpus[c].dispatches;
+    }
+
+    // End of the window after a step: up to then every CPU can run on its
+    // own. Nothing arrives and the migration pass stays out before it.
+    // Stealing needs a CPU without work and a queue with work its CPU is not
+    // running, so while any queue holds work the window also closes when a
+    // busy CPU runs dry and, if a CPU is idle already, at the next slice end
+    // of a CPU with a queue. Migration runs after the preemption check, so a
+    // process it moved may still have to preempt at the next event; then
+    // there is no window at all.
+    long long horizon(long long t, long long next_arrival, long long next_balance) const {
+        if (opt.balance == SmpOptions::Balance::Migrate) {
+            for (int c = 0; c < (int)cpu.size(); ++c) {
+                const Cpu& k = cpu[c];
+                int top = k.running >= 0 ? k.rq->peek() : -1;
+                if (top >= 0 && k.rq->preempts(top, k.running, (*table)[k.running].remaining_time - ranFor(c, t)))
+                    return t;
+            }
+            return std::min(next_arrival, next_balance);
+        }
+        bool queued = false, idle = false;
+        for (const Cpu& k : cpu) {
+            queued |= k.rq->size() > 0;
+            idle |= k.running < 0 && k.rq->size() == 0;
+        }
+        long long w = next_arrival;
+        if (!queued) return w;
+        for (const Cpu& k : cpu) {
+            if (k.running < 0) continue;
+            w = std::min(w, k.start + k.work);
+            if (idle && k.rq->size() > 0) w = std::min(w, k.end);
+        }
+        return w;
+    }
+
+    // Plays c's slice ends, requeues and dispatches before `until`, logging
+    // the hooks instead of calling them. Returns completions.
+    int advance(int c, long long until, std::vector<Deferred>& log) {
+        Cpu& k = cpu[c];
+        int done = 0;
+        while (k.running >= 0 && k.end < until) {
+            long long t = k.end;
+            int i = k.running;
+            SimTime amount = ranFor(c, t);
+            if (endSlice(c, t) == SliceEnd::Finished) {
+                ++done;
+                log.push_back({t, Deferred::Complete, c, i, 0});
+            } else {
+                k.rq->ran(i, amount);
+                k.rq->push(i);
+                log.push_back({t, Deferred::Requeue, c, i, k.rq->size()});
+            }
+            std::size_t depth = k.rq->size();
+            int j = k.rq->pop();
+            if (j < 0) break;
+            startSlice(c, j, t);
+            log.push_back({t, Deferred::Dispatch, c, j, depth});
+        }
+        return done;
+    }
+
+    // Runs every CPU up to `until`, partitions of CPUs on the workers when
+    // enough of them have events, then replays the hooks in sequential
+    // order. Returns completions; `t` moves to the last event.
+    int window(WindowWorkers& workers, long long until, long long& t) {
+        const int m = (int)cpu.size();
+        int active = 0;
+        for (const Cpu& k : cpu) active += k.running >= 0 && k.end < until;
+        if (active == 0) return 0;
+        int parts = active < workers.size() ? 1 : workers.size();
+        auto part = [&, parts](int w) {
+            logs[w].clear();
+            finished[w] = 0;
+            for (int c = m * w / parts; c < m * (w + 1) / parts; ++c) finished[w] += advance(c, until, logs[w]);
+        };
+        if (parts == 1) part(0);
+        else workers.run(part);
+
+        merged.clear();
+        int done = 0;
+        for (int w = 0; w < parts; ++w) {
+            merged.insert(merged.end(), logs[w].begin(), logs[w].end());
+            done += finished[w];
+        }
+        std::sort(merged.begin(), merged.end());
+        for (const Deferred& d : merged) {
+            Process* p = &(*table)[d.proc];
+            if (d.phase == Deferred::Complete) ctr.complete(p, d.t);
+            else if (d.phase == Deferred::Requeue) ctr.enqueue(p, d.depth, d.t);
+            else { ctr.dequeue(); ctr.dispatch(p, d.depth, d.t); }
+        }
+        t = std::max(t, merged.back().t);
+        return done;
+    }
+
+public:
+    SmpScheduler(std::string policy_, int quantum_, SmpOptions o)
+        : policy(std::move(policy_)), quantum(quantum_), opt(o) { cpus = std::max(1, o.cpus); }
+
+    const SmpReport* smp() const override { return &report; }
+    // Snapshots cover the single-CPU schedulers only.
+    bool attachCheckpoints(Checkpoints* c) override { return !c; }
+
+protected:
+    void run(ProcessTable& procs, GanttChart& gantt, SimTime& total_time) override {
+        const int n = (int)procs.size(), m = cpus;
+        sortByArrival(procs, true);
+        for (auto& p : procs) {
+            p.remaining_time = p.burst_time;
+            if (policy == "edf" && p.deadline == 0) p.deadline = p.arrival_time + 2 * p.burst_time;
+        }
+        st = SmpTaskState{ReadyVector<double>(n, 0.0), ReadyVector<int>(n, 0), {}, {}};
+        table = &procs;
+        predictor.reset();
+        report.prediction = PredictionStats();
+        if (opt.predict > 0 && (policy == "sjf" || policy == "srtf")) {
+            predictor = std::make_unique<BurstPredictor>(opt.predict, opt.predict_initial);
+            predictor->reset(procs);
+            st.predicted.assign(n, 0);
+            st.burst.assign(n, 0);
+        }
+        cpu.clear();
+        cpu.resize(m);
+        for (int c = 0; c < m; ++c) cpu[c].rq = smp_detail::makeRunQueue(policy, quantum, c, procs, st, opt.groups);
+        report.tracks.assign(m, GanttChart());
+        report.cpus.assign(m, SmpCpuStats());
+        covered.assign(m, 0);
+        left_at.assign(n, -1);
+        last_cpu.assign(n, -1);
+        devs.clear();
+        report.device_names.clear();
+        report.io_overlap = 0;
+        if (opt.io) {
+            gens.clear();
+            gens.resize(n);
+            blocked.assign(n, 0);
+            blocked_since.assign(n, 0);
+            for (const IoDevice& d : opt.io->devices) {
+                devs.emplace_back(d);
+                report.device_names.push_back(d.name);
+            }
+        }
+        std::unique_ptr<WindowWorkers> workers;
+        if (std::min(opt.threads, m) > 1) {
+            workers = std::make_unique<WindowWorkers>(std::min(opt.threads, m));
+            logs.assign(workers->size(), {});
+            finished.assign(workers->size(), 0);
+        }
+
+        auto enqueue = [&](int c, int i, long long t) {
+            cpu[c].rq->push(i);
+            ctr.enqueue(&procs[i], cpu[c].rq->size(), t);
+        };
+        auto move = [&](int from, int to, long long t) {
+            int i = cpu[from].rq->pop();
+            ctr.dequeue();
+            cpu[from].work -= procs[i].remaining_time;
+            cpu[to].work += procs[i].remaining_time;
+            enqueue(to, i, t);
+            ++report.cpus[from].migrations_out;
+            ++report.cpus[to].migrations_in;
+        };
+        // Ends the running slice at t; returns the process if it is not done.
+        auto stop = [&](int c, long long t) {
+            int i = cpu[c].running;
+            SliceEnd e = endSlice(c, t);
+            if (e == SliceEnd::Ready) return i;
+            if (e == SliceEnd::Finished) ctr.complete(&procs[i], t);
+            return -1;
+        };
+        // Arrivals and processes back from I/O go to the least loaded CPU.
+        auto place = [&](int i, long long t) {
+            int best = 0;
+            for (int c = 1; c < m; ++c) if (load(c) < load(best)) best = c;
+            cpu[best].work += procs[i].remaining_time;
+            enqueue(best, i, t);
+        };
+
+        long long t = 0, next_balance = opt.interval;
+        int next = 0, done = 0;
+        std::vector<std::pair<int, int>> requeue;
+        while (done < n) {
+            // Next event: an arrival, a slice end or a migration pass.
+            long long nt = next < n ? procs[next].arrival_time : LLONG_MAX;
+            bool queued = false, busy = false;
+            for (int c = 0; c < m; ++c) {
+                if (cpu[c].running >= 0) { nt = std::min(nt, cpu[c].end); busy = true; }
+                queued |= cpu[c].rq->size() > 0;
+            }
+            if (opt.balance == SmpOptions::Balance::Migrate && queued) nt = std::min(nt, next_balance);
+            bool io_busy = false;
+            long long first_run = LLONG_MAX;
+            for (const IoDeviceQueue& d : devs)
+                if (d.serving >= 0) { nt = std::min(nt, d.done_at); io_busy = true; }
+            SIM_ASSERT(nt != LLONG_MAX, "smp engine ran out of events");
+            if (!busy && !queued && nt > t) ctr.idle(t);
+            // CPU/I-O overlap over [t, nt): devices only change at events
+            if (io_busy) {
+                for (const Cpu& k : cpu) if (k.running >= 0) first_run = std::min(first_run, k.start);
+                long long from = std::max(t, first_run);
+                if (from < nt) report.io_overlap += nt - from;
+            }
+            t = std::max(t, nt);
+
+            for (int c = 0; c < m; ++c)
+                if (cpu[c].running >= 0 && cpu[c].end == t) {
+                    int i = cpu[c].running;
+                    SimTime amount = ranFor(c, t);
+                    SliceEnd e = endSlice(c, t);
+                    if (e == SliceEnd::Finished) { ctr.complete(&procs[i], t); ++done; }
+                    else if (e == SliceEnd::Ready) { cpu[c].rq->ran(i, amount); requeue.emplace_back(c, i); }
+                }
+            for (IoDeviceQueue& d : devs) {
+                if (d.serving >= 0 && d.done_at == t) {
+                    int i = d.finish();
+                    blocked[i] += t - blocked_since[i];
+                    place(i, t);
+                }
+                d.start(t);
+            }
+            for (; next < n && procs[next].arrival_time <= t; ++next) {
+                // A process's phases are generated from its arrival on
+                if (opt.io && procs[next].program >= 0) {
+                    gens[next] = opt.io->start(procs[next].program);
+                    procs[next].remaining_time = gens[next]->phase().cpu;
+                }
+                predictBurst(next);
+                place(next, t);
+            }
+            for (auto [c, i] : requeue) enqueue(c, i, t);
+            requeue.clear();
+
+            // Preemptive policies: a better process on the queue takes the CPU.
+            for (int c = 0; c < m; ++c) {
+                Cpu& k = cpu[c];
+                if (k.running < 0) continue;
+                int top = k.rq->peek();
+                if (top < 0 || !k.rq->preempts(top, k.running, procs[k.running].remaining_time - ranFor(c, t)))
+                    continue;
+                int i = stop(c, t);
+                enqueue(c, i, t);
+            }
+
+            if (opt.balance == SmpOptions::Balance::Steal) {
+                for (int c = 0; c < m; ++c) {
+                    if (load(c) > 0) continue;
+                    int victim = -1;
+                    // Only work its own CPU cannot start now is worth taking.
+                    for (int v = 0; v < m; ++v)
+                        if (v != c && cpu[v].rq->size() > (cpu[v].running >= 0 ? 0u : 1u) &&
+                            (victim < 0 || cpu[v].rq->size() > cpu[victim].rq->size()))
+                            victim = v;
+                    if (victim >= 0) move(victim, c, t);
+                }
+            } else if (t >= next_balance) {
+                for (;;) {
+                    int hi = 0, lo = 0;
+                    for (int c = 1; c < m; ++c) {
+                        if (load(c) > load(hi)) hi = c;
+                        if (load(c) < load(lo)) lo = c;
+                    }
+                    if (load(hi) <= load(lo) + 1 || cpu[hi].rq->size() == 0) break;
+                    move(hi, lo, t);
+                }
+                next_balance = t + opt.interval;
+            }
+
+            for (int c = 0; c < m; ++c) {
+                Cpu& k = cpu[c];
+                if (k.running >= 0) continue;
+                std::size_t depth = k.rq->size();
+                int i = k.rq->pop();
+                if (i < 0) continue;
+                ctr.dequeue();
+                ctr.dispatch(&procs[i], depth, t);
+                startSlice(c, i, t);
+            }
+
+            // Predictions learn from every burst, so they keep the sequential order.
+            if (workers && !opt.io && !predictor) {
+                long long arrival = next < n ? procs[next].arrival_time : LLONG_MAX;
+                done += window(*workers, horizon(t, arrival, next_balance), t);
+            }
+        }
+        for (int c = 0; c < m; ++c)
+            if (covered[c] < t) emit(report.tracks[c], covered[c], "IDLE", covered[c], t);
+        for (const SmpCpuStats& s : report.cpus) this->acc.overhead(s.overhead);
+        report.devices.clear();
+        for (const IoDeviceQueue& d : devs) report.devices.push_back(d.stats);
+        if (predictor) report.prediction = predictor->stats();
+        gantt = report.tracks[0];
+        total_time = (SimTime)t;
+    }
+};
+
+template <class Counters = SchedCounters<false>>
+std::unique_ptr<Scheduler> makeSmpScheduler(const std::string& type, int quantum, SmpOptions opt) {
+    ProcessTable probe;
+    SmpTaskState st;
+    if (!smp_detail::makeRunQueue(type, quantum, 0, probe, st)) return nullptr;
+    return std::make_unique<SmpScheduler<Counters>>(type, quantum, opt);
+}
+
+// The single-CPU schedulers for one CPU, the SMP engine for more, when
+// switch costs are modelled, when the workload does I/O, for group CFS and for
+// SJF/SRTF on predicted bursts.
+template <class Counters = SchedCounters<false>>
+std::unique_ptr<Scheduler> makeScheduler(const std::string& type, int quantum, const SmpOptions& opt) {
+    bool predicted = opt.predict > 0 && (type == "sjf" || type == "srtf");
+    return opt.cpus > 1 || opt.overheads() || opt.io || (opt.groups && type == "cfs") || predicted ? makeSmpScheduler<Counters>(type, quantum, opt) : makeScheduler<Counters>(type, quantum);
+}
+
+// Per-CPU Gantt tracks and utilization, taking the place of the one-line
+// chart in the text report.
+inline void printSmpReport(std::ostream& out, const SmpReport& r, long long total_time) {
+    OutBuffer b(out);
+    for (std::size_t c = 0; c < r.tracks.size(); ++c) {
+        b.put("CPU ").num((long long)c).put(" Gantt: ");
+        for (const auto& e : r.tracks[c]) b.put(e.first).put('(').num((long long)e.second).put(") ");
+        b.put('\n');
+    }
+    for (std::size_t c = 0; c < r.cpus.size(); ++c) {
+        const SmpCpuStats& s = r.cpus[c];
+        b.put("CPU ").num((long long)c).put(": utilization ")
+         .num6(total_time > 0 ? 100.0 * s.busy / total_time : 0).put("%, dispatches ")
+         .num((long long)s.dispatches).put(", migrations in ").num((long long)s.migrations_in)
+         .put(" out ").num((long long)s.migrations_out);
+        if (s.overhead > 0) b.put(", overhead ").num(s.overhead);
+        b.put('\n');
+    }
+    for (std::size_t d = 0; d < r.devices.size(); ++d) {
+        const IoDeviceStats& s = r.devices[d];
+        b.put("Device ").put(r.device_names[d]).put(": utilization ")
+         .num6(total_time > 0 ? 100.0 * s.busy / total_time : 0).put("%, requests ").num((long long)s.requests)
+         .put(", avg queue wait ").num6(s.requests ? (double)s.queued / s.requests : 0)
+         .put(", max queue ").num((long long)s.max_queue).put('\n');
+    }
+    if (r.prediction.bursts)
+        b.put("Burst prediction: ").num((long long)r.prediction.bursts).put(" bursts, mean abs error ")
+         .num6(r.prediction.meanAbsError()).put(" (").num6(r.prediction.meanRelError()).put("% of the burst), bias ")
+         .num6(r.prediction.bias()).put('\n');
+    if (!r.devices.empty())
+        b.put("CPU/I-O overlap: ").num(r.io_overlap).put(" (")
+         .num6(total_time > 0 ? 100.0 * r.io_overlap / total_time : 0).put("% of the run)\n");
+}
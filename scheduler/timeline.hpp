@@ -0,0 +1,85 @@
+// timeline.hpp
+// Chrome Trace Event export of a run, loadable in Perfetto or chrome://tracing.
+// Every process is a track (one tid per process) holding its CPU slices, with
+// instant events for its arrival, completion and, when it finishes past its
+// deadline, the miss. Events are written from the scheduling hooks as the run
+// goes, through a buffered writer, so nothing proportional to the schedule is
+// held in memory. One simulated time unit is shown as one microsecond.
+#pragma once
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+
+#include "results.hpp"
+
+class TimelineWriter {
+    OutBuffer b;
+    bool first = true;
+    bool running = false;
+    std::uint32_t current = 0;
+    std::int64_t since = 0;
+    std::string_view current_id;
+
+    // Opens an event object; the caller writes the remaining fields and '}'.
+    void begin(std::string_view name, char phase, std::int64_t ts, std::uint32_t track) {
+        b.put(first ? "\n" : ",\n");
+        first = false;
+        b.put("{\"name\":");
+        results_detail::jsonString(b, name);
+        b.put(",\"ph\":\"").put(phase).put("\",\"ts\":").num((long long)ts)
+         .put(",\"pid\":1,\"tid\":").num((long long)track);
+    }
+    void stop(std::int64_t now) {
+        if (!running) return;
+        running = false;
+        if (now <= since) return;
+        begin(current_id, 'X', since, current);
+        b.put(",\"dur\":").num((long long)(now - since)).put('}');
+    }
+
+public:
+    TimelineWriter(std::ostream& out, std::string_view scheduler) : b(out) {
+        b.put("{\"traceEvents\":[");
+        begin("process_name", 'M', 0, 0);
+        b.put(",\"args\":{\"name\":");
+        results_detail::jsonString(b, scheduler);
+        b.put("}}");
+    }
+    ~TimelineWriter() { b.put("\n]}\n"); }
+
+    // Tracks are numbered from 1 so that tid 0 stays free.
+    template <class P> void dispatch(std::uint32_t index, const P& p, std::int64_t now) {
+        std::uint32_t track = index + 1;
+        if (p.start_time < 0) {
+            begin("thread_name", 'M', 0, track);
+            b.put(",\"args\":{\"name\":");
+            results_detail::jsonString(b, p.id);
+            b.put("}}");
+            begin("arrival", 'i', p.arrival_time, track);
+            b.put(",\"s\":\"t\"}");
+        }
+        // Back-to-back slices of one process (SRTF's ticks) read as one.
+        if (running && track == current) return;
+        stop(now);
+        running = true;
+        current = track;
+        since = now;
+        current_id = p.id;
+    }
+
+    template <class P> void complete(std::uint32_t index, const P& p, std::int64_t now) {
+        stop(now);
+        std::uint32_t track = index + 1;
+        begin("complete", 'i', now, track);
+        b.put(",\"s\":\"t\",\"args\":{\"waiting\":").num((long long)p.waiting_time)
+         .put(",\"turnaround\":").num((long long)p.turnaround_time).put("}}");
+        if (p.deadline > 0 && now > p.deadline) {
+            begin("deadline miss", 'i', now, track);
+            b.put(",\"s\":\"t\",\"args\":{\"deadline\":").num((long long)p.deadline)
+             .put(",\"late\":").num((long long)(now - p.deadline)).put("}}");
+        }
+    }
+
+    // Closes the slice still open when a run ends.
+    void finish(std::int64_t end) { stop(end); b.flush(); }
+};
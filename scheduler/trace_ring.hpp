@@ -0,0 +1,254 @@
+// trace_ring.hpp
+// Fixed-size ring of the most recent scheduling events, one per thread, kept
+// on by default so a surprising decision can be inspected after the fact.
+// Writing is a single-producer store into preallocated storage: no locks, no
+// allocation. The ring is dumped with raw write(2) calls, which keeps the dump
+// safe to run from the SIGABRT/SIGUSR1 handlers installed by the simulator.
+// Those dump every thread's ring, since the signal lands on whichever thread
+// the kernel picks, usually the idle main thread of a batch run: rings are
+// registered in a fixed table and never freed, a finished thread's ring going
+// to the next thread that starts.
+//
+// Build with -DSIM_TRACE_RING=0 to compile the recording out entirely.
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include <utility>
+
+#ifndef SIM_TRACE_RING
+#define SIM_TRACE_RING 1
+#endif
+#ifndef SIM_TRACE_RING_SIZE
+#define SIM_TRACE_RING_SIZE (1u << 14)
+#endif
+
+enum class TraceEvent : std::uint8_t { Enqueue = 1, Dispatch, Idle, Complete };
+
+inline const char* traceEventName(unsigned type) {
+    switch (type) {
+        case (unsigned)TraceEvent::Enqueue:  return "enqueue";
+        case (unsigned)TraceEvent::Dispatch: return "dispatch";
+        case (unsigned)TraceEvent::Idle:     return "idle";
+        case (unsigned)TraceEvent::Complete: return "complete";
+    }
+    return "?";
+}
+
+struct TraceRecord {
+    std::int64_t time;
+    std::uint32_t proc;       // index into the scheduled process vector
+    std::uint32_t depth : 28; // ready-queue length, saturating
+    std::uint32_t type : 4;   // TraceEvent
+};
+static_assert(sizeof(TraceRecord) == 16, "trace records are dumped verbatim");
+
+struct TraceDumpHeader {
+    char magic[8];            // "SIMTRACE"
+    std::uint32_t version;
+    std::uint32_t record_size;
+    std::uint64_t count;      // records that follow, oldest first
+    std::uint64_t total;      // records ever written; total - count were overwritten
+};
+
+class TraceRing {
+public:
+    static constexpr std::size_t kSize = SIM_TRACE_RING_SIZE;
+    static_assert((kSize & (kSize - 1)) == 0, "ring size must be a power of two");
+
+    bool enabled = SIM_TRACE_RING != 0;
+
+    void record(TraceEvent type, long long time, std::uint32_t proc, std::size_t depth) {
+#if SIM_TRACE_RING
+        if (!enabled) return;
+        std::uint64_t h = head.load(std::memory_order_relaxed);
+        TraceRecord& r = buf[h & (kSize - 1)];
+        r.time = time;
+        r.proc = proc;
+        r.depth = depth < (1u << 28) ? (std::uint32_t)depth : (1u << 28) - 1;
+        r.type = (std::uint32_t)type;
+        head.store(h + 1, std::memory_order_release);
+#else
+        (void)type; (void)time; (void)proc; (void)depth;
+#endif
+    }
+
+    void clear() { head.store(0, std::memory_order_relaxed); }
+    std::uint64_t written() const { return head.load(std::memory_order_acquire); }
+
+    // Async-signal-safe: only open/write/close on preallocated memory.
+    bool dump(const char* path) const {
+        int fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) return false;
+        bool ok = write(fd);
+        ::close(fd);
+        return ok;
+    }
+
+    // Header and records, oldest first, to an open file.
+    bool write(int fd) const {
+        std::uint64_t total = written();
+        std::uint64_t count = total < kSize ? total : kSize;
+        TraceDumpHeader hdr;
+        std::memcpy(hdr.magic, "SIMTRACE", 8);
+        hdr.version = 1;
+        hdr.record_size = sizeof(TraceRecord);
+        hdr.count = count;
+        hdr.total = total;
+        bool ok = ::write(fd, &hdr, sizeof hdr) == (ssize_t)sizeof hdr;
+        // Oldest records sit at head when the ring has wrapped.
+        std::size_t first = (std::size_t)((total - count) & (kSize - 1));
+        std::size_t tail = count < kSize - first ? (std::size_t)count : kSize - first;
+        ok = ok && ::write(fd, &buf[first], tail * sizeof(TraceRecord)) == (ssize_t)(tail * sizeof(TraceRecord));
+        if (count > tail)
+            ok = ok && ::write(fd, &buf[0], (count - tail) * sizeof(TraceRecord)) ==
+                           (ssize_t)((count - tail) * sizeof(TraceRecord));
+        return ok;
+    }
+
+private:
+    TraceRecord buf[kSize];
+    std::atomic<std::uint64_t> head{0};
+};
+
+// Every thread's ring, for the signal handlers to dump at once.
+class TraceRings {
+    static constexpr std::size_t kMax = 256;
+    std::atomic<TraceRing*> rings[kMax];   // zero-initialized: only ever a static
+    std::atomic<bool> busy[kMax];
+
+public:
+    // A registered ring for the calling thread; nullptr once kMax threads
+    // hold one.
+    TraceRing* acquire() {
+        for (std::size_t i = 0; i < kMax; ++i) {
+            bool free = false;
+            if (!busy[i].compare_exchange_strong(free, true)) continue;
+            TraceRing* r = rings[i].load();
+            if (!r) rings[i].store(r = new TraceRing);
+            r->clear();
+            r->enabled = SIM_TRACE_RING != 0;
+            return r;
+        }
+        return nullptr;
+    }
+    void release(const TraceRing* r) {
+        for (std::size_t i = 0; i < kMax; ++i)
+            if (rings[i].load() == r) busy[i].store(false);
+    }
+
+    // Async-signal-safe: one section per ring that has recorded anything,
+    // finished threads' included until their ring is taken again.
+    bool dump(const char* path) const {
+        int fd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) return false;
+        bool ok = true, wrote = false;
+        const TraceRing* quiet = nullptr;   // written alone when no ring has anything
+        for (std::size_t i = 0; i < kMax; ++i) {
+            const TraceRing* r = rings[i].load();
+            if (!r) continue;
+            if (!r->written()) { if (!quiet) quiet = r; continue; }
+            ok = r->write(fd) && ok;
+            wrote = true;
+        }
+        if (!wrote && quiet) ok = quiet->write(fd);
+        ::close(fd);
+        return ok;
+    }
+};
+
+inline TraceRings& traceRings() {
+    static TraceRings all;
+    return all;
+}
+
+// One ring per thread, so batch workers never share one.
+inline TraceRing& traceRing() {
+    struct Owner {
+        TraceRing* ring = traceRings().acquire();
+        bool shared = ring != nullptr;
+        Owner() { if (!shared) ring = new TraceRing; }
+        ~Owner() { if (shared) traceRings().release(ring); else delete ring; }
+    };
+    static thread_local Owner owner;
+    return *owner.ring;
+}
+
+// Where the signal handlers and SIM_ASSERT put the ring.
+inline char g_trace_dump_path[512] = "sim_trace.bin";
+
+inline void setTraceDumpPath(const char* path) {
+    std::snprintf(g_trace_dump_path, sizeof g_trace_dump_path, "%s", path);
+}
+
+// Checked invariant that leaves the recent history behind when it fails.
+#define SIM_ASSERT(cond, msg)                                                        \
+    do {                                                                             \
+        if (!(cond)) {                                                               \
+            std::fprintf(stderr, "%s:%d: assertion failed: %s (%s)\n",               \
+                         __FILE__, __LINE__, #cond, msg);                            \
+            if (traceRing().dump(g_trace_dump_path))                                 \
+                std::fprintf(stderr, "trace ring dumped to %s\n", g_trace_dump_path); \
+            std::abort();                                                            \
+        }                                                                            \
+    } while (0)
+
+// Prints a dump written by TraceRing::dump, or by TraceRings::dump with one
+// section per thread. A dump taken at the end of a run is followed by the
+// process ids, one per line, which replace the indices.
+inline bool decodeTraceDump(const char* path, std::ostream& out) {
+    std::FILE* f = std::fopen(path, "rb");
+    if (!f) return false;
+    std::vector<std::pair<TraceDumpHeader, std::vector<TraceRecord>>> sections;
+    std::vector<std::string> ids;
+    bool ok = true;
+    for (;;) {
+        long at = std::ftell(f);
+        TraceDumpHeader hdr;
+        if (std::fread(&hdr, sizeof hdr, 1, f) != 1 || std::memcmp(hdr.magic, "SIMTRACE", 8) != 0) {
+            std::fseek(f, at, SEEK_SET);
+            break;
+        }
+        std::vector<TraceRecord> recs;
+        ok = hdr.record_size == sizeof(TraceRecord) && hdr.count <= TraceRing::kSize;
+        if (ok) {
+            recs.resize(hdr.count);
+            ok = std::fread(recs.data(), sizeof(TraceRecord), recs.size(), f) == recs.size();
+        }
+        if (!ok) break;
+        sections.emplace_back(hdr, std::move(recs));
+    }
+    ok = ok && !sections.empty();
+    if (ok) {
+        char line[256];
+        while (ok && std::fgets(line, sizeof line, f)) {
+            ids.emplace_back(line);
+            if (!ids.back().empty() && ids.back().back() == '\n') ids.back().pop_back();
+        }
+    }
+    std::fclose(f);
+    if (!ok) return false;
+    for (std::size_t k = 0; k < sections.size(); ++k) {
+        const auto& [hdr, recs] = sections[k];
+        out << "# ";
+        if (sections.size() > 1) out << "thread " << k << ": ";
+        out << hdr.count << " of " << hdr.total << " events\n";
+        for (const auto& r : recs) {
+            out << r.time << " " << traceEventName(r.type);
+            if (r.type != (unsigned)TraceEvent::Idle) {
+                if (r.proc < ids.size()) out << " " << ids[r.proc];
+                else out << " #" << r.proc;
+            }
+            out << " depth=" << r.depth << "\n";
+        }
+    }
+    return true;
+}
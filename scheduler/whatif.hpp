@@ -0,0 +1,273 @@
+// whatif.hpp
+// Incremental re-simulation for what-if analysis. A baseline run keeps a
+// light snapshot (checkpoint.hpp) every `interval` units of simulated time;
+// an edited copy of the workload then goes on from the last snapshot taken
+// before any edit could have mattered instead of from 0, and stops as soon as
+// one of its own snapshots has the same core as the baseline's at the same
+// time with every edited process finished. From there both runs go on alike,
+// so the rest of the process table and the Gantt chart are the baseline's and
+// the metrics are rebuilt from the spliced table. The span replayed follows
+// the perturbation rather than the length of the trace; setting up and
+// splicing the tables stays linear in the workload.
+//
+// fcfs, sjf, srtf, priority, rr and edf only look at a process once it has
+// arrived, so a replay restarts before the earliest arrival, old or new, of
+// an edited process. mlq, mlfq, lottery and cfs queue every process at 0 and
+// replay from the start, still stopping at convergence. An edit that reorders
+// the table, moving an arrival past another, can neither restore a snapshot
+// nor converge and replays in full.
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "simulator.hpp"
+
+struct ProcessEdit {
+    enum Field { Arrival, Burst, Priority, Deadline };
+    std::string id;
+    Field field = Burst;
+    long long value = 0;
+};
+
+// One scenario: the edits on one line of a what-if file.
+struct WhatIf {
+    std::string name;             // the line as written
+    std::vector<ProcessEdit> edits;
+};
+
+// Lines of "ID field=value ..." with fields arrival, burst, priority and
+// deadline; later IDs on a line add to the same scenario. '#' starts a
+// comment.
+inline bool loadWhatIfs(const std::string& path, std::vector<WhatIf>& out, std::string& error) {
+    std::ifstream file(path);
+    if (!file) { error = "Could not open what-if file: " + path; return false; }
+    std::string line;
+    for (int number = 1; std::getline(file, line); ++number) {
+        line = line.substr(0, line.find('#'));
+        std::istringstream in(line);
+        WhatIf w;
+        std::string id, tok;
+        while (in >> tok) {
+            std::size_t eq = tok.find('=');
+            if (eq == std::string::npos) { id = tok; continue; }
+            auto bad = [&] { error = path + ":" + std::to_string(number) + ": bad edit " + tok; return false; };
+            if (id.empty()) return bad();
+            std::string field = tok.substr(0, eq), value = tok.substr(eq + 1);
+            ProcessEdit e;
+            e.id = id;
+            if (field == "arrival") e.field = ProcessEdit::Arrival;
+            else if (field == "burst") e.field = ProcessEdit::Burst;
+            else if (field == "priority") e.field = ProcessEdit::Priority;
+            else if (field == "deadline") e.field = ProcessEdit::Deadline;
+            else return bad();
+            char* end = nullptr;
+            e.value = std::strtoll(value.c_str(), &end, 10);
+            bool time = e.field != ProcessEdit::Priority;
+            if (value.empty() || *end || (time ? e.value < 0 || e.value > kMaxSimTime
+                                               : e.value < INT_MIN || e.value > INT_MAX))
+                return bad();
+            w.edits.push_back(std::move(e));
+        }
+        if (w.edits.empty()) continue;
+        std::size_t from = line.find_first_not_of(" \t"), to = line.find_last_not_of(" \t\r");
+        w.name = line.substr(from, to + 1 - from);
+        out.push_back(std::move(w));
+    }
+    return true;
+}
+
+// Policies that never look at a process before it arrives.
+inline bool arrivalOrdered(const std::string& type) {
+    return type == "fcfs" || type == "sjf" || type == "srtf" || type == "priority" || type == "rr" || type == "edf";
+}
+
+// Metrics of a finished table, as its run's events would have added them up.
+inline MetricsAccumulator metricsOf(const ProcessTable& procs, SimTime total_time) {
+    MetricsAccumulator m;
+    for (const auto& p : procs) {
+        if (p.start_time >= 0) m.firstDispatch(p.arrival_time, p.start_time);
+        m.complete(p.waiting_time, p.turnaround_time, p.burst_time);
+    }
+    m.finish(total_time);
+    return m;
+}
+
+struct WhatIfResult {
+    long long restart = 0;        // simulated time the replay went on from
+    long long converged = -1;     // where it met the baseline, -1 when it ran to the end
+    ProcessTable procs;
+    GanttChart gantt;
+    SimTime total_time = 0;
+    MetricsAccumulator metrics;
+    double seconds = 0;           // wall clock of the replay
+};
+
+class IncrementalSim {
+    std::string type;
+    int quantum;
+    long long interval;
+    std::unique_ptr<Scheduler> scheduler;
+    ProcessTable work;                                  // the workload as loaded
+    std::unordered_map<std::string, std::size_t> index; // id -> row of `work`
+    ProcessTable base_procs;                            // the baseline's final tables
+    GanttChart base_gantt;
+    SimTime base_total = 0;
+    MetricsAccumulator base_metrics;
+    std::map<long long, Snapshot> snaps;                // baseline snapshots by time / interval
+
+    // Runs `procs` with `cp` attached.
+    void run(ProcessTable& procs, GanttChart& gantt, SimTime& total_time, Checkpoints& cp) {
+        scheduler->attachCheckpoints(&cp);
+        scheduler->schedule(procs, gantt, total_time);
+        scheduler->attachCheckpoints(nullptr);
+    }
+
+    Checkpoints checkpoints() const {
+        Checkpoints cp;
+        cp.scheduler = type;
+        cp.quantum = quantum;
+        cp.interval = interval;
+        cp.full = false;
+        return cp;
+    }
+
+public:
+    // `interval` 0 takes about 64 snapshots over the baseline.
+    IncrementalSim(std::string type_, int quantum_, ProcessTable workload, long long interval_ = 0)
+        : type(std::move(type_)), quantum(quantum_), interval(interval_), work(std::move(workload)) {
+        scheduler = makeScheduler(type, quantum);
+        if (interval <= 0) {
+            long long span = 0;
+            for (const auto& p : work) span = std::max<long long>(span, p.arrival_time) + p.burst_time;
+            interval = std::max(1LL, span / 64);
+        }
+        index.reserve(work.size());
+        for (std::size_t i = 0; i < work.size(); ++i) index.emplace(work[i].id, i);
+    }
+
+    // False when `type` is not a single-CPU scheduler.
+    bool valid() const { return scheduler != nullptr; }
+    long long snapshotInterval() const { return interval; }
+    std::size_t snapshots() const { return snaps.size(); }
+
+    // Runs the baseline, keeping its snapshots.
+    void baseline() {
+        snaps.clear();
+        base_procs = work;
+        base_gantt.clear();
+        Checkpoints cp = checkpoints();
+        cp.taken = [&](Snapshot& s) {
+            long long k = s.time / interval;
+            snaps.emplace(k, std::move(s));
+            return false;
+        };
+        run(base_procs, base_gantt, base_total, cp);
+        base_metrics = scheduler->metrics();
+    }
+    const ProcessTable& baseProcs() const { return base_procs; }
+    const GanttChart& baseGantt() const { return base_gantt; }
+    SimTime baseTotal() const { return base_total; }
+    const MetricsAccumulator& baseMetrics() const { return base_metrics; }
+
+    // Replays the baseline with `w`'s edits; false with `error` set when an
+    // edit names no process.
+    bool rerun(const WhatIf& w, WhatIfResult& r, std::string& error) {
+        auto start = std::chrono::steady_clock::now();
+        ProcessTable edited = work;
+        std::vector<std::string> ids;
+        long long first = kMaxSimTime;
+        bool moved = false;
+        for (const auto& e : w.edits) {
+            auto it = index.find(e.id);
+            if (it == index.end()) { error = "No process " + e.id + " in the workload"; return false; }
+            Process& p = edited[it->second];
+            first = std::min<long long>(first, p.arrival_time);
+            switch (e.field) {
+            case ProcessEdit::Arrival:  p.arrival_time = (SimTime)e.value; moved = true; break;
+            case ProcessEdit::Burst:    p.burst_time = p.remaining_time = (SimTime)e.value; break;
+            case ProcessEdit::Priority: p.priority = (int)e.value; break;
+            case ProcessEdit::Deadline: p.deadline = (SimTime)e.value; break;
+            }
+            first = std::min<long long>(first, p.arrival_time);
+            ids.push_back(e.id);
+        }
+        if (moved)
+            sortByArrival(edited, true);
+        if (!arrivalOrdered(type)) first = 0;
+
+        const Snapshot* from = nullptr;
+        for (const auto& [k, s] : snaps) {
+            if (s.time >= first) break;
+            from = &s;
+        }
+
+        // Converged once a snapshot matches the baseline's with every edited
+        // process done; the edited rows are found in the run's own order.
+        Checkpoints cp = checkpoints();
+        cp.resume = from;
+        cp.base_procs = &base_procs;
+        cp.base_gantt = &base_gantt;
+        r.procs = edited;
+        r.gantt.clear();
+        r.total_time = 0;
+        r.converged = -1;
+        std::vector<std::size_t> rows;
+        bool located = false;
+        std::size_t base_segments = 0;
+        cp.taken = [&](Snapshot& s) {
+            auto it = snaps.find(s.time / interval);
+            if (it == snaps.end()) return false;
+            const Snapshot& b = it->second;
+            if (b.time != s.time || b.ids != s.ids || b.core != s.core) return false;
+            if (!located) {
+                for (std::size_t i = 0; i < r.procs.size(); ++i)
+                    if (std::find(ids.begin(), ids.end(), r.procs[i].id) != ids.end()) rows.push_back(i);
+                located = true;
+            }
+            for (std::size_t i : rows)
+                if (!snapshot_detail::settled(r.procs[i])) return false;
+            r.converged = s.time;
+            base_segments = snapshotSegments(b);
+            return true;
+        };
+        run(r.procs, r.gantt, r.total_time, cp);
+        if (!cp.error.empty()) {
+            // The snapshot does not fit the edited table, e.g. it was reordered
+            cp.resume = from = nullptr;
+            r.procs = std::move(edited);
+            r.gantt.clear();
+            r.total_time = 0;
+            located = false;
+            rows.clear();
+            run(r.procs, r.gantt, r.total_time, cp);
+        }
+        r.restart = from ? from->time : 0;
+
+        if (cp.stopped) {
+            for (std::size_t i = 0; i < r.procs.size(); ++i) {
+                Process& p = r.procs[i];
+                if (snapshot_detail::settled(p)) continue;
+                const Process& b = base_procs[i];
+                p.remaining_time = b.remaining_time;
+                p.waiting_time = b.waiting_time;
+                p.turnaround_time = b.turnaround_time;
+                p.start_time = b.start_time;
+            }
+            r.gantt.insert(r.gantt.end(), base_gantt.begin() + (std::ptrdiff_t)base_segments, base_gantt.end());
+            r.total_time = base_total;
+            r.metrics = metricsOf(r.procs, r.total_time);
+        } else {
+            r.metrics = scheduler->metrics();
+        }
+        r.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        return true;
+    }
+};